@@ -0,0 +1,361 @@
+/**
+ *  BitmapMemoryAllocator.cpp
+ *
+ *  Purpose:
+ *      Implements a frame-granular memory allocator that tracks occupancy with
+ *      one bit per frame. Allocation searches the bitmap for N contiguous free
+ *      frames, skipping fully used or fully free 256-bit blocks with a single
+ *      vector test so large memories can be scanned quickly.
+ */
+#include "BitmapMemoryAllocator.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BITMAP_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BITMAP_USE_SSE2
+#endif
+
+namespace {
+	const size_t WORD_BITS = 64;
+	const size_t BLOCK_WORDS = 4;  // 256 bits per vector block
+	const size_t BLOCK_FRAMES = BLOCK_WORDS * WORD_BITS;
+
+	// Classifies four bitmap words as all free (0), all used (1) or mixed (2)
+	int classifyBlock(const uint64_t* words) {
+#if defined(BITMAP_USE_AVX2)
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+		if (_mm256_testz_si256(v, v)) {
+			return 0;
+		}
+		if (_mm256_testc_si256(v, _mm256_set1_epi64x(-1))) {
+			return 1;
+		}
+		return 2;
+#elif defined(BITMAP_USE_SSE2)
+		__m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+		__m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2));
+		__m128i zero = _mm_setzero_si128();
+		__m128i ones = _mm_set1_epi32(-1);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(lo, hi), zero)) == 0xFFFF) {
+			return 0;
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), ones)) == 0xFFFF) {
+			return 1;
+		}
+		return 2;
+#else
+		if ((words[0] | words[1] | words[2] | words[3]) == 0) {
+			return 0;
+		}
+		if ((words[0] & words[1] & words[2] & words[3]) == ~0ULL) {
+			return 1;
+		}
+		return 2;
+#endif
+	}
+}
+
+BitmapMemoryAllocator::BitmapMemoryAllocator(size_t maximumSize, size_t frameSize, string backing)
+	: maximumSize(maximumSize), frameSize(frameSize == 0 ? 1 : frameSize), memory(maximumSize, backing)
+{
+	numFrames = this->maximumSize / this->frameSize;
+
+	// Pad to whole vector blocks; padding frames are marked used so they are never handed out
+	size_t words = (numFrames + WORD_BITS - 1) / WORD_BITS;
+	words = (words + BLOCK_WORDS - 1) / BLOCK_WORDS * BLOCK_WORDS;
+	bitmap.assign(words, 0);
+	for (size_t frame = numFrames; frame < words * WORD_BITS; ++frame) {
+		bitmap[frame / WORD_BITS] |= 1ULL << (frame % WORD_BITS);
+	}
+	size_t blocks = words / BLOCK_WORDS;
+	fullBlocks.assign((blocks + WORD_BITS - 1) / WORD_BITS, 0);
+	blockSummaries.assign(blocks, { 0, 0, 0 });
+	if (words > 0) {
+		updateBlockSummaries(0, words - 1);
+	}
+}
+
+BitmapMemoryAllocator::~BitmapMemoryAllocator()
+{
+}
+
+void BitmapMemoryAllocator::markFrames(size_t firstFrame, size_t frameCount, bool used) {
+	size_t frame = firstFrame;
+	size_t end = firstFrame + frameCount;
+	while (frame < end) {
+		size_t bit = frame % WORD_BITS;
+		size_t span = std::min(WORD_BITS - bit, end - frame);
+		uint64_t mask = (span == WORD_BITS) ? ~0ULL : (((1ULL << span) - 1) << bit);
+		if (used) {
+			bitmap[frame / WORD_BITS] |= mask;
+		}
+		else {
+			bitmap[frame / WORD_BITS] &= ~mask;
+		}
+		frame += span;
+	}
+	updateBlockSummaries(firstFrame / WORD_BITS, (end - 1) / WORD_BITS);
+}
+
+void BitmapMemoryAllocator::updateBlockSummaries(size_t firstWord, size_t lastWord) {
+	for (size_t block = firstWord / BLOCK_WORDS; block <= lastWord / BLOCK_WORDS; ++block) {
+		uint64_t mask = 1ULL << (block % WORD_BITS);
+		BlockSummary& summary = blockSummaries[block];
+		int kind = classifyBlock(&bitmap[block * BLOCK_WORDS]);
+
+		if (kind == 1) {
+			fullBlocks[block / WORD_BITS] |= mask;
+			summary = { 0, 0, 0 };
+			continue;
+		}
+		fullBlocks[block / WORD_BITS] &= ~mask;
+		if (kind == 0) {
+			summary = { BLOCK_FRAMES, BLOCK_FRAMES, BLOCK_FRAMES };
+			continue;
+		}
+
+		// Mixed block: measure its free runs
+		size_t run = 0;
+		size_t prefix = 0;
+		size_t maxRun = 0;
+		bool seenUsed = false;
+		for (size_t w = 0; w < BLOCK_WORDS; ++w) {
+			uint64_t bits = bitmap[block * BLOCK_WORDS + w];
+			size_t bit = 0;
+			while (bit < WORD_BITS) {
+				uint64_t rest = bits >> bit;
+				if (rest & 1) {
+					if (!seenUsed) {
+						prefix = run;
+						seenUsed = true;
+					}
+					maxRun = std::max(maxRun, run);
+					run = 0;
+					bit += std::countr_one(rest);
+				}
+				else {
+					size_t zeros = (rest == 0) ? WORD_BITS - bit : static_cast<size_t>(std::countr_zero(rest));
+					run += zeros;
+					bit += zeros;
+				}
+			}
+		}
+		maxRun = std::max(maxRun, run);
+		summary = { static_cast<uint16_t>(prefix), static_cast<uint16_t>(run), static_cast<uint16_t>(maxRun) };
+	}
+}
+
+size_t BitmapMemoryAllocator::findRunInBlock(size_t block, size_t frameCount) {
+	size_t runStart = 0;
+	size_t runLength = 0;
+	for (size_t w = 0; w < BLOCK_WORDS; ++w) {
+		size_t word = block * BLOCK_WORDS + w;
+		uint64_t bits = bitmap[word];
+		size_t bit = 0;
+		while (bit < WORD_BITS) {
+			uint64_t rest = bits >> bit;
+			if (rest & 1) {
+				runLength = 0;
+				bit += std::countr_one(rest);
+			}
+			else {
+				size_t zeros = (rest == 0) ? WORD_BITS - bit : static_cast<size_t>(std::countr_zero(rest));
+				if (runLength == 0) {
+					runStart = word * WORD_BITS + bit;
+				}
+				runLength += zeros;
+				if (runLength >= frameCount) {
+					return runStart;
+				}
+				bit += zeros;
+			}
+		}
+	}
+	return NO_RUN;
+}
+
+size_t BitmapMemoryAllocator::findFreeRun(size_t frameCount) {
+	if (frameCount == 0 || frameCount > numFrames) {
+		return NO_RUN;
+	}
+
+	// First fit over blocks; frames below searchHint are known to be in use
+	size_t runStart = 0;
+	size_t runLength = 0;
+	size_t block = searchHint / BLOCK_FRAMES;
+	size_t numBlocks = blockSummaries.size();
+
+	while (block < numBlocks) {
+		uint64_t full = fullBlocks[block / WORD_BITS] >> (block % WORD_BITS);
+		if (full & 1) {
+			// Skip every consecutive full block covered by this summary word
+			runLength = 0;
+			block += std::countr_one(full);
+			continue;
+		}
+
+		const BlockSummary& summary = blockSummaries[block];
+		if (summary.prefixFree == BLOCK_FRAMES) {
+			if (runLength == 0) {
+				runStart = block * BLOCK_FRAMES;
+			}
+			runLength += BLOCK_FRAMES;
+			if (runLength >= frameCount) {
+				return runStart;
+			}
+			++block;
+			continue;
+		}
+
+		// A run carried in from earlier blocks ends inside this one
+		if (runLength + summary.prefixFree >= frameCount) {
+			return (runLength > 0) ? runStart : block * BLOCK_FRAMES;
+		}
+		if (summary.maxRun >= frameCount) {
+			return findRunInBlock(block, frameCount);
+		}
+
+		runLength = summary.suffixFree;
+		runStart = (block + 1) * BLOCK_FRAMES - summary.suffixFree;
+		++block;
+	}
+
+	return NO_RUN;
+}
+
+void* BitmapMemoryAllocator::allocate(size_t size, int pid) {
+	if (size == 0) {
+		return nullptr;
+	}
+	size_t frameCount = (size + frameSize - 1) / frameSize;
+
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	size_t firstFrame = findFreeRun(frameCount);
+	if (firstFrame == NO_RUN || !memory.commit(firstFrame * frameSize, frameCount * frameSize)) {
+		return nullptr;
+	}
+
+	markFrames(firstFrame, frameCount, true);
+	allocations[firstFrame] = { frameCount, pid };
+	allocatedFrames += frameCount;
+	if (firstFrame <= searchHint) {
+		searchHint = firstFrame + frameCount;
+	}
+	return memory.data() + firstFrame * frameSize;
+}
+
+void BitmapMemoryAllocator::deallocate(void* ptr) {
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	size_t firstFrame = (static_cast<char*>(ptr) - memory.data()) / frameSize;
+	auto it = allocations.find(firstFrame);
+	if (it == allocations.end()) {
+		return;
+	}
+
+	markFrames(firstFrame, it->second.frameCount, false);
+	allocatedFrames -= it->second.frameCount;
+	allocations.erase(it);
+	searchHint = std::min(searchHint, firstFrame);
+}
+
+std::string_view BitmapMemoryAllocator::viewMemory(size_t offset, size_t count) {
+	return memory.view(offset, count);
+}
+
+std::string BitmapMemoryAllocator::getAllocatorStats() {
+	return "Simulated memory: " + memory.describe() + "\n";
+}
+
+std::vector<IMemoryAllocator::MemoryRun> BitmapMemoryAllocator::getMemoryMap() {
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+
+	// Allocations and the frames between them, converted to byte addresses
+	std::vector<MemoryRun> runs;
+	size_t gapStart = 0;
+	for (const auto& allocation : allocations) {
+		size_t start = allocation.first * frameSize;
+		if (start > gapStart) {
+			runs.push_back({ gapStart, start, FREE_RUN });
+		}
+		gapStart = start + allocation.second.frameCount * frameSize;
+		runs.push_back({ start, gapStart, allocation.second.pid });
+	}
+	if (maximumSize > gapStart) {
+		runs.push_back({ gapStart, maximumSize, FREE_RUN });
+	}
+	return runs;
+}
+
+size_t BitmapMemoryAllocator::calculateExternalFragmentation() {
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	return (numFrames - allocatedFrames) * frameSize;
+}
+
+size_t BitmapMemoryAllocator::getNumberOfProcessesInMemory() {
+	std::lock_guard<std::mutex> lock(allocatorMutex);
+	return allocations.size();
+}
+
+void BitmapMemoryAllocator::runBenchmark(size_t maximumSize, size_t frameSize, size_t minSize, size_t maxSize) {
+	BitmapMemoryAllocator allocator(maximumSize, frameSize);
+	std::mt19937 gen(12345);
+	std::uniform_int_distribution<size_t> sizeDis(minSize, maxSize);
+	std::vector<void*> live;
+
+	// Phase 1: fill memory to 75% with back-to-back allocations
+	auto start = std::chrono::steady_clock::now();
+	size_t fillAllocations = 0;
+	while (allocator.allocatedFrames < allocator.numFrames / 4 * 3) {
+		void* ptr = allocator.allocate(sizeDis(gen), 0);
+		if (!ptr) {
+			break;
+		}
+		live.push_back(ptr);
+		fillAllocations++;
+	}
+	double fillSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Phase 2: churn with random frees and allocations, which fragments the front of memory
+	start = std::chrono::steady_clock::now();
+	const size_t churn = 20000;
+	size_t churnAllocations = 0;
+	size_t failures = 0;
+	for (size_t i = 0; i < churn && !live.empty(); ++i) {
+		std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+		size_t victim = pick(gen);
+		allocator.deallocate(live[victim]);
+		live[victim] = live.back();
+		live.pop_back();
+
+		void* ptr = allocator.allocate(sizeDis(gen), 0);
+		if (ptr) {
+			live.push_back(ptr);
+			churnAllocations++;
+		}
+		else {
+			failures++;
+		}
+	}
+	double churnSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+#if defined(BITMAP_USE_AVX2)
+	const char* scanner = "AVX2";
+#elif defined(BITMAP_USE_SSE2)
+	const char* scanner = "SSE2";
+#else
+	const char* scanner = "scalar";
+#endif
+	cout << "Bitmap allocator benchmark (" << scanner << " scan)" << endl;
+	cout << "Simulated memory: " << maximumSize << " bytes in " << allocator.numFrames << " frames of " << frameSize << endl;
+	cout << "Fill:  " << fillAllocations << " allocations in " << fillSeconds << " s ("
+		<< static_cast<size_t>(fillAllocations / (fillSeconds > 0 ? fillSeconds : 1)) << " allocations/sec)" << endl;
+	cout << "Churn: " << churnAllocations << " allocations (" << failures << " failed) in " << churnSeconds << " s ("
+		<< static_cast<size_t>((churnAllocations + failures) / (churnSeconds > 0 ? churnSeconds : 1)) << " allocations/sec)" << endl;
+}
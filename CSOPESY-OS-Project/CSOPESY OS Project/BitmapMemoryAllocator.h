@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "IMemoryAllocator.h"
+#include "SimulatedMemory.h"
+
+using namespace std;
+
+// Frame-granular allocator backend. Occupancy is kept as one bit per frame
+// and runs of free frames are found by scanning the bitmap 256 bits at a time
+// (AVX2 / SSE2 when available, plain 64-bit words otherwise). Per-block run
+// summaries and a bitmap of fully used blocks let the first-fit scan skip
+// full or fragmented regions without walking them bit by bit.
+class BitmapMemoryAllocator : public IMemoryAllocator
+{
+public:
+	BitmapMemoryAllocator(size_t maximumSize, size_t frameSize, string backing = "anonymous");
+	~BitmapMemoryAllocator();
+
+	void* allocate(size_t size, int pid) override;
+	void deallocate(void* ptr) override;
+	std::string_view viewMemory(size_t offset, size_t count) override;
+	std::string getAllocatorStats() override;
+	vector<MemoryRun> getMemoryMap() override;
+	size_t calculateExternalFragmentation() override;
+	size_t getNumberOfProcessesInMemory() override;
+
+	size_t findFreeRun(size_t frameCount);
+	static void runBenchmark(size_t maximumSize, size_t frameSize, size_t minSize, size_t maxSize);
+
+	static const size_t NO_RUN = static_cast<size_t>(-1);
+
+private:
+	struct Allocation
+	{
+		size_t frameCount;
+		int pid;
+	};
+
+	// Free-run lengths of one 256-frame block, so the scan can accept or reject it without walking its bits
+	struct BlockSummary
+	{
+		uint16_t prefixFree;  // free frames at the start of the block
+		uint16_t suffixFree;  // free frames at the end of the block
+		uint16_t maxRun;  // longest free run inside the block
+	};
+
+	void markFrames(size_t firstFrame, size_t frameCount, bool used);
+	void updateBlockSummaries(size_t firstWord, size_t lastWord);
+	size_t findRunInBlock(size_t block, size_t frameCount);
+
+	size_t maximumSize;
+	size_t frameSize;
+	size_t numFrames;
+	size_t allocatedFrames = 0;
+	size_t searchHint = 0;  // no free frame exists below this index
+	std::vector<uint64_t> bitmap;  // 1 bit per frame, set = in use
+	std::vector<uint64_t> fullBlocks;  // 1 bit per 256-frame block, set = every frame in use
+	std::vector<BlockSummary> blockSummaries;
+	SimulatedMemory memory;
+	std::map<size_t, Allocation> allocations;  // first frame -> allocation
+	std::mutex allocatorMutex;
+};
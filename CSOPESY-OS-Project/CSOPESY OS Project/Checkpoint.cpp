@@ -0,0 +1,329 @@
+#include "Checkpoint.h"
+#include "ConsoleManager.h"
+#include "Scheduler.h"
+#include "Screen.h"
+#include "ProcessTable.h"
+#include "Cluster.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+	const char MAGIC[8] = { 'C', 'S', 'O', 'P', 'C', 'K', 'P', 'T' };
+
+	// Appends fixed-width values to one buffer that is written in a single call
+	class Writer
+	{
+	public:
+		template <typename T>
+		void put(T value)
+		{
+			const char* bytes = reinterpret_cast<const char*>(&value);
+			buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+		void putString(const string& value)
+		{
+			put(static_cast<uint32_t>(value.size()));
+			buffer.insert(buffer.end(), value.begin(), value.end());
+		}
+
+		vector<char> buffer;
+	};
+
+	// Reads values back from the loaded file; every read fails once the data runs out
+	class Reader
+	{
+	public:
+		explicit Reader(const vector<char>& buffer) : buffer(buffer) {}
+
+		template <typename T>
+		bool get(T& value)
+		{
+			if (buffer.size() - offset < sizeof(T)) {
+				return false;
+			}
+			std::memcpy(&value, buffer.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return true;
+		}
+
+		bool getString(string& value)
+		{
+			uint32_t length = 0;
+			if (!get(length) || buffer.size() - offset < length) {
+				return false;
+			}
+			value.assign(buffer.data() + offset, length);
+			offset += length;
+			return true;
+		}
+
+		bool atEnd() const
+		{
+			return offset == buffer.size();
+		}
+
+	private:
+		const vector<char>& buffer;
+		size_t offset = 0;
+	};
+
+	// One process section entry, parsed before anything is applied
+	struct SavedProcess
+	{
+		int32_t pid = 0;
+		string name;
+		string timestamp;
+		uint64_t memoryRequired = 0;
+		uint8_t priority = 0;
+		int32_t currentLine = 0;
+		int32_t totalLine = 0;
+		int32_t coreId = 0;
+		uint8_t state = 0;
+		int64_t finishedAt = 0;
+		vector<Screen::BlockingInstruction> blocking;
+	};
+
+	vector<int> allProcessPids()
+	{
+		vector<int> pids;
+		for (ProcessTable::State state : { ProcessTable::READY, ProcessTable::RUNNING, ProcessTable::WAITING, ProcessTable::FINISHED }) {
+			vector<int> members = ProcessTable::getInstance()->getPidsInState(state);
+			pids.insert(pids.end(), members.begin(), members.end());
+		}
+		std::sort(pids.begin(), pids.end());  // creation order, so names intern in the same order on restore
+		return pids;
+	}
+}
+
+bool Checkpoint::save(const string& path, string& error)
+{
+	ConsoleManager* consoleManager = ConsoleManager::getInstance();
+	Scheduler* scheduler = Scheduler::getInstance();
+	if (Cluster::getInstance()->getNumNodes() > 1) {
+		error = "checkpoints only support a single node (num-nodes 1)";
+		return false;
+	}
+
+	// Quiesce: no new batch processes, and every core stopped between instructions
+	std::unique_lock<std::mutex> batchLock = consoleManager->pauseBatchGeneration();
+	bool wasRunning = scheduler->isRunning();
+	scheduler->stop();
+
+	Writer writer;
+	writer.buffer.insert(writer.buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+	writer.put(VERSION);
+
+	// Clocks
+	writer.put(static_cast<uint64_t>(scheduler->getCpuCycles()));
+	writer.put(static_cast<int32_t>(consoleManager->getProcessCounter()));
+
+	// Allocator: memory is only held during a burst, so after the drain the layout is
+	// empty and the configuration is what a restore has to match
+	writer.putString(consoleManager->getMemoryAllocatorConfig());
+	writer.put(static_cast<uint64_t>(consoleManager->getMaxOverallMem()));
+	writer.put(static_cast<uint64_t>(consoleManager->getMemPerFrame()));
+
+	// Process table and programs
+	vector<int> pids = allProcessPids();
+	writer.put(static_cast<uint32_t>(pids.size()));
+	for (int pid : pids) {
+		shared_ptr<Screen> screen = static_pointer_cast<Screen>(consoleManager->getScreen(pid));
+		ProcessTable::Snapshot snapshot = screen->getSnapshot();
+		writer.put(static_cast<int32_t>(pid));
+		writer.putString(screen->getProcessName());
+		writer.putString(screen->getTimestamp());
+		writer.put(static_cast<uint64_t>(screen->getMemoryRequired()));
+		writer.put(static_cast<uint8_t>(screen->getPriority()));
+		writer.put(static_cast<int32_t>(snapshot.currentLine));
+		writer.put(static_cast<int32_t>(snapshot.totalLine));
+		writer.put(static_cast<int32_t>(snapshot.coreId));
+		writer.put(static_cast<uint8_t>(snapshot.state));
+		writer.put(static_cast<int64_t>(snapshot.finishedAt));
+
+		vector<Screen::BlockingInstruction> blocking = screen->getBlockingInstructions();
+		writer.put(static_cast<uint32_t>(blocking.size()));
+		for (const Screen::BlockingInstruction& instruction : blocking) {
+			writer.put(static_cast<int32_t>(instruction.line));
+			writer.put(static_cast<uint8_t>(instruction.type));
+			writer.put(static_cast<int32_t>(instruction.ticks));
+		}
+	}
+
+	// Ready queue, front first
+	vector<shared_ptr<Screen>> queued = scheduler->getQueuedProcesses();
+	writer.put(static_cast<uint32_t>(queued.size()));
+	for (const shared_ptr<Screen>& process : queued) {
+		writer.put(static_cast<int32_t>(process->getPid()));
+	}
+
+	// Processes blocked on the timer wheel
+	vector<pair<shared_ptr<Screen>, uint64_t>> sleeping = scheduler->getSleepingProcesses();
+	writer.put(static_cast<uint32_t>(sleeping.size()));
+	for (const auto& sleeper : sleeping) {
+		writer.put(static_cast<int32_t>(sleeper.first->getPid()));
+		writer.put(static_cast<uint64_t>(sleeper.second));
+	}
+
+	if (wasRunning) {
+		scheduler->start();
+	}
+
+	ofstream file(path, ios::binary | ios::trunc);
+	if (!file.write(writer.buffer.data(), writer.buffer.size())) {
+		error = "could not write " + path;
+		return false;
+	}
+	return true;
+}
+
+bool Checkpoint::restore(const string& path, string& error)
+{
+	ConsoleManager* consoleManager = ConsoleManager::getInstance();
+	Scheduler* scheduler = Scheduler::getInstance();
+	if (Cluster::getInstance()->getNumNodes() > 1) {
+		error = "checkpoints only support a single node (num-nodes 1)";
+		return false;
+	}
+
+	ifstream file(path, ios::binary);
+	if (!file) {
+		error = "could not open " + path;
+		return false;
+	}
+	vector<char> buffer((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	Reader reader(buffer);
+
+	char magic[sizeof(MAGIC)];
+	uint32_t version = 0;
+	uint64_t cpuCycles = 0;
+	int32_t processCounter = 0;
+	string backend;
+	uint64_t maxOverallMem = 0;
+	uint64_t memPerFrame = 0;
+	bool valid = reader.get(magic) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 && reader.get(version);
+	if (!valid || version != VERSION) {
+		error = path + " is not a checkpoint file";
+		return false;
+	}
+	if (!reader.get(cpuCycles) || !reader.get(processCounter)
+		|| !reader.getString(backend) || !reader.get(maxOverallMem) || !reader.get(memPerFrame)) {
+		error = path + " is truncated";
+		return false;
+	}
+	if (backend != consoleManager->getMemoryAllocatorConfig() || maxOverallMem != consoleManager->getMaxOverallMem()
+		|| memPerFrame != consoleManager->getMemPerFrame()) {
+		error = "checkpoint memory configuration (" + backend + ", " + to_string(maxOverallMem) + " bytes, "
+			+ to_string(memPerFrame) + " per frame) does not match config.txt";
+		return false;
+	}
+
+	// The whole file is parsed and checked before anything is touched, so a truncated
+	// or corrupt checkpoint leaves the emulator as it was
+	uint32_t processCount = 0;
+	valid = reader.get(processCount);
+	vector<SavedProcess> processes;
+	unordered_map<int32_t, size_t> savedIndex;  // saved pid -> position in processes
+	unordered_set<string> names;
+	for (uint32_t i = 0; i < processCount && valid; i++) {
+		SavedProcess process;
+		uint32_t blockingCount = 0;
+		valid = reader.get(process.pid) && reader.getString(process.name) && reader.getString(process.timestamp)
+			&& reader.get(process.memoryRequired) && reader.get(process.priority) && reader.get(process.currentLine)
+			&& reader.get(process.totalLine) && reader.get(process.coreId) && reader.get(process.state)
+			&& reader.get(process.finishedAt) && reader.get(blockingCount);
+		valid = valid && process.state <= ProcessTable::FINISHED && process.priority <= Screen::LOWEST_PRIORITY
+			&& process.totalLine >= 0 && process.currentLine >= 0 && process.currentLine <= process.totalLine;
+		// Blocking lines are SLEEP/IO instructions inside the program, in program order
+		for (uint32_t j = 0; j < blockingCount && valid; j++) {
+			int32_t line = 0, ticks = 0;
+			uint8_t type = 0;
+			valid = reader.get(line) && reader.get(type) && reader.get(ticks)
+				&& (type == ICommand::SLEEP || type == ICommand::IO) && ticks > 0
+				&& line >= 0 && line < process.totalLine && (process.blocking.empty() || line > process.blocking.back().line);
+			process.blocking.push_back({ line, static_cast<ICommand::CommandType>(type), ticks });
+		}
+		valid = valid && savedIndex.emplace(process.pid, processes.size()).second && names.insert(process.name).second;
+		if (valid) {
+			processes.push_back(std::move(process));
+		}
+	}
+
+	// A process is in at most one of the ready queue and the timer wheel, in the state that goes with it
+	unordered_set<int32_t> placed;
+	auto placeable = [&](int32_t pid, bool asleep) {
+		auto saved = savedIndex.find(pid);
+		if (saved == savedIndex.end() || !placed.insert(pid).second) {
+			return false;
+		}
+		uint8_t state = processes[saved->second].state;
+		return asleep ? state == ProcessTable::WAITING : (state == ProcessTable::READY || state == ProcessTable::RUNNING);
+	};
+
+	uint32_t queuedCount = 0;
+	valid = valid && reader.get(queuedCount);
+	vector<int32_t> queued;
+	for (uint32_t i = 0; i < queuedCount && valid; i++) {
+		int32_t pid = 0;
+		valid = reader.get(pid) && placeable(pid, false);
+		queued.push_back(pid);
+	}
+
+	uint32_t sleepingCount = 0;
+	valid = valid && reader.get(sleepingCount);
+	vector<pair<int32_t, int>> sleeping;
+	for (uint32_t i = 0; i < sleepingCount && valid; i++) {
+		int32_t pid = 0;
+		uint64_t ticksLeft = 0;
+		valid = reader.get(pid) && reader.get(ticksLeft) && ticksLeft <= INT_MAX && placeable(pid, true);
+		sleeping.emplace_back(pid, static_cast<int>(ticksLeft));
+	}
+
+	if (!valid || !reader.atEnd()) {
+		error = path + " is truncated or corrupt; nothing was restored";
+		return false;
+	}
+
+	std::unique_lock<std::mutex> batchLock = consoleManager->pauseBatchGeneration();
+	if (scheduler->getSchedulerTestRunning() || !allProcessPids().empty()) {
+		error = "restore needs a freshly initialized emulator with no processes";
+		return false;
+	}
+	bool wasRunning = scheduler->isRunning();
+	scheduler->stop();
+
+	// Processes keep their names; pids are re-interned and mapped from the saved ones
+	vector<shared_ptr<Screen>> restored;
+	restored.reserve(processes.size());
+	for (const SavedProcess& process : processes) {
+		auto screen = make_shared<Screen>(process.name, process.timestamp, static_cast<size_t>(process.memoryRequired), process.totalLine, process.blocking);
+		screen->setPriority(process.priority);
+		screen->setCurrentLine(process.currentLine);
+		screen->setCPUCoreID(process.coreId);
+		// Cores were drained before saving, so nothing is mid-burst
+		ProcessTable::State savedState = static_cast<ProcessTable::State>(process.state);
+		ProcessTable::getInstance()->publishRelease(screen->getPid(),
+			savedState == ProcessTable::RUNNING ? ProcessTable::READY : savedState, process.finishedAt);
+		consoleManager->registerConsole(screen);
+		restored.push_back(screen);
+	}
+	for (int32_t pid : queued) {
+		scheduler->addProcessToQueue(restored[savedIndex[pid]]);
+	}
+	for (const auto& sleeper : sleeping) {
+		scheduler->sleepProcess(restored[savedIndex[sleeper.first]], sleeper.second);
+	}
+
+	scheduler->setCpuCycles(cpuCycles);
+	consoleManager->setProcessCounter(processCounter);
+	if (wasRunning) {
+		scheduler->start();
+	}
+	return true;
+}
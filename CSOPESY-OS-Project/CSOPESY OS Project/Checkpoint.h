@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Saves and loads the emulator state (process table, programs, ready queue,
+// sleeping processes, clocks and allocator configuration) as one compact
+// binary file. Saving drains the cores to an instruction boundary so the
+// state written is consistent, then resumes the scheduler; loading rebuilds
+// the processes into a freshly initialized emulator.
+//
+// Layout (native byte order): "CSOPCKPT", u32 version, then the clock,
+// allocator, process, ready queue and sleeper sections in that order.
+// Strings are a u32 length followed by the bytes.
+class Checkpoint
+{
+public:
+	static bool save(const string& path, string& error);
+	static bool restore(const string& path, string& error);
+
+private:
+	static const uint32_t VERSION = 2;
+};
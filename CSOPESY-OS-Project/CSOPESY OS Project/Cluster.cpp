@@ -0,0 +1,307 @@
+#include "Cluster.h"
+#include "ConsoleManager.h"
+#include "IMemoryAllocator.h"
+#include "Scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "WorkloadRandom.h"
+#include "EmulatorContext.h"
+
+void Cluster::initialize(int numNodes)
+{
+	// Re-initializing stops every node and frees the ones it owns before any of them is replaced
+	Cluster*& cluster = EmulatorContext::current()->cluster;
+	if (cluster != nullptr) {
+		cluster->stop();
+		delete cluster;
+	}
+	cluster = new Cluster();
+
+	// Node 0 is the shared allocator and scheduler the rest of the emulator uses; both replace the previous ones
+	ConsoleManager* consoleManager = ConsoleManager::getInstance();
+	IMemoryAllocator::initialize(consoleManager->getMaxOverallMem(),
+		consoleManager->getMemPerFrame(),
+		consoleManager->getMemoryAllocatorConfig(),
+		consoleManager->getNumCpu(),
+		consoleManager->getMagazineSize(),
+		consoleManager->getMemoryBacking());
+	Scheduler::getInstance()->initialize(consoleManager->getNumCpu());
+
+	cluster->placement = consoleManager->getClusterPlacement();
+	numNodes = std::max(1, std::min(numNodes, MAX_NODES));
+	for (int i = 0; i < numNodes; i++) {
+		auto node = std::make_unique<Node>();
+		if (i == 0) {
+			node->scheduler = Scheduler::getInstance();
+			node->memoryAllocator = IMemoryAllocator::getInstance();
+			node->owned = false;
+		}
+		else {
+			// A file-backed memory gets one file per node
+			string backing = consoleManager->getMemoryBacking();
+			if (!backing.empty() && backing != "anonymous") {
+				backing += ".node" + to_string(i);
+			}
+			node->memoryAllocator = IMemoryAllocator::create(consoleManager->getMaxOverallMem(),
+				consoleManager->getMemPerFrame(),
+				consoleManager->getMemoryAllocatorConfig(),
+				consoleManager->getNumCpu(),
+				consoleManager->getMagazineSize(),
+				backing);
+			node->scheduler = new Scheduler(consoleManager->getNumCpu());
+			node->owned = true;
+		}
+		node->memoryAllocator->setNodeId(i);
+		node->scheduler->setNode(i, node->memoryAllocator);
+		cluster->nodes.push_back(std::move(node));
+	}
+}
+
+Cluster* Cluster::getInstance()
+{
+	Cluster*& cluster = EmulatorContext::current()->cluster;
+	if (cluster == nullptr) {
+		cluster = new Cluster();
+	}
+	return cluster;
+}
+
+Cluster::~Cluster()
+{
+	stop();
+	for (auto& node : nodes) {
+		if (node->owned) {
+			delete node->scheduler;
+			delete node->memoryAllocator;
+		}
+	}
+}
+
+void Cluster::start()
+{
+	for (auto& node : nodes) {
+		node->scheduler->start();
+	}
+	if (nodes.size() > 1 && !balancing) {
+		balancing = true;
+		balancerThread = EmulatorContext::startThread([this] { runBalancer(); });
+	}
+}
+
+void Cluster::stop()
+{
+	balancing = false;
+	if (balancerThread.joinable()) {
+		balancerThread.join();
+	}
+	for (auto& node : nodes) {
+		node->scheduler->stop();
+	}
+}
+
+int Cluster::getNumNodes() const
+{
+	return static_cast<int>(nodes.size());
+}
+
+Scheduler* Cluster::getScheduler(int node) const
+{
+	return nodes[node]->scheduler;
+}
+
+IMemoryAllocator* Cluster::getMemoryAllocator(int node) const
+{
+	return nodes[node]->memoryAllocator;
+}
+
+bool Cluster::setNumCores(int numCores)
+{
+	bool resized = true;
+	for (auto& node : nodes) {
+		resized = node->scheduler->setNumCores(numCores) && resized;
+	}
+	return resized;
+}
+
+double Cluster::getLoad(int node) const
+{
+	Scheduler* scheduler = nodes[node]->scheduler;
+	int queued = scheduler->getQueuedCount();
+	int running = scheduler->getCoresUsed();
+	return static_cast<double>(queued + running) / std::max(1, scheduler->getNumCores());
+}
+
+int Cluster::pickLeastLoaded() const
+{
+	int best = 0;
+	double bestLoad = getLoad(0);
+	for (int i = 1; i < getNumNodes(); i++) {
+		double load = getLoad(i);
+		if (load < bestLoad) {
+			best = i;
+			bestLoad = load;
+		}
+	}
+	return best;
+}
+
+int Cluster::pickByMemory(size_t memoryRequired) const
+{
+	// Headroom: free memory left once everything already queued on the node is loaded
+	int best = -1;
+	int roomiest = 0;
+	long long roomiestHeadroom = 0;
+	for (int i = 0; i < getNumNodes(); i++) {
+		long long freeMemory = static_cast<long long>(nodes[i]->memoryAllocator->calculateExternalFragmentation());
+		long long headroom = freeMemory - static_cast<long long>(nodes[i]->scheduler->getQueuedMemory());
+		if (i == 0 || headroom > roomiestHeadroom) {
+			roomiest = i;
+			roomiestHeadroom = headroom;
+		}
+		if (headroom >= static_cast<long long>(memoryRequired) && (best == -1 || getLoad(i) < getLoad(best))) {
+			best = i;
+		}
+	}
+	return best != -1 ? best : roomiest;
+}
+
+int Cluster::pickPowerOfTwo()
+{
+	WorkloadRandom& random = WorkloadRandom::forThread(WorkloadRandom::PLACEMENT);
+	int first = random.uniform(0, getNumNodes() - 1);
+	int second = random.uniform(0, getNumNodes() - 1);
+	return getLoad(second) < getLoad(first) ? second : first;
+}
+
+int Cluster::place(shared_ptr<Screen> process)
+{
+	if (nodes.empty()) {
+		Scheduler::getInstance()->addProcessToQueue(process);
+		return 0;
+	}
+
+	int node = 0;
+	if (nodes.size() > 1) {
+		if (placement == "memory") {
+			node = pickByMemory(process->getMemoryRequired());
+		}
+		else if (placement == "p2c") {
+			node = pickPowerOfTwo();
+		}
+		else {
+			node = pickLeastLoaded();
+		}
+	}
+
+	process->setNode(node);
+	nodes[node]->placed.fetch_add(1, std::memory_order_relaxed);
+	nodes[node]->scheduler->addProcessToQueue(process);
+	return node;
+}
+
+int Cluster::rebalance()
+{
+	int moved = 0;
+	int limit = 0;
+	for (auto& node : nodes) {
+		limit += node->scheduler->getQueuedCount();
+	}
+
+	// One process at a time, re-measuring, so two nodes never trade the same work back and forth
+	while (moved < limit) {
+		int busiest = 0;
+		int idlest = 0;
+		for (int i = 1; i < getNumNodes(); i++) {
+			if (getLoad(i) > getLoad(busiest)) {
+				busiest = i;
+			}
+			if (getLoad(i) < getLoad(idlest)) {
+				idlest = i;
+			}
+		}
+		// Moving one process narrows the gap by step; stop once that would no longer help
+		double gap = getLoad(busiest) - getLoad(idlest);
+		double step = 1.0 / std::max(1, nodes[busiest]->scheduler->getNumCores()) + 1.0 / std::max(1, nodes[idlest]->scheduler->getNumCores());
+		if (busiest == idlest || gap < 1.0 || gap <= step) {
+			break;
+		}
+
+		shared_ptr<Screen> process = nodes[busiest]->scheduler->stealQueuedProcess();
+		if (!process) {
+			break;
+		}
+		// Its last core belongs to the other node, so the first dispatch here is a fresh start
+		process->setCPUCoreID(-1);
+		process->setNode(idlest);
+		nodes[busiest]->migratedOut.fetch_add(1, std::memory_order_relaxed);
+		nodes[idlest]->migratedIn.fetch_add(1, std::memory_order_relaxed);
+		migrations.fetch_add(1, std::memory_order_relaxed);
+		nodes[idlest]->scheduler->addProcessToQueue(process);
+		moved++;
+	}
+	return moved;
+}
+
+void Cluster::runBalancer()
+{
+	// Paced by node 0's clock
+	Scheduler* clock = nodes[0]->scheduler;
+	uint64_t nextTick = clock->getCpuCycles() + 1;
+	while (balancing) {
+		if (!clock->waitForTick(nextTick, std::chrono::milliseconds(100))) {
+			continue;
+		}
+		nextTick = clock->getCpuCycles() + 1;
+		rebalance();
+	}
+}
+
+int Cluster::getCoresUsed() const
+{
+	if (nodes.empty()) {
+		return Scheduler::getInstance()->getCoresUsed();
+	}
+	int used = 0;
+	for (const auto& node : nodes) {
+		used += node->scheduler->getCoresUsed();
+	}
+	return used;
+}
+
+int Cluster::getCoresAvailable() const
+{
+	if (nodes.empty()) {
+		return Scheduler::getInstance()->getCoresAvailable();
+	}
+	int available = 0;
+	for (const auto& node : nodes) {
+		available += node->scheduler->getCoresAvailable();
+	}
+	return available;
+}
+
+uint64_t Cluster::getMigrations() const
+{
+	return migrations.load(std::memory_order_relaxed);
+}
+
+void Cluster::printNodes(ostream& out)
+{
+	out << "Nodes: " << nodes.size() << " (placement " << placement << ")" << "\n";
+	out << "Node  Cores  Used  Util    Queued  Free memory  Placed  Migrated in  Migrated out" << "\n";
+	for (int i = 0; i < getNumNodes(); i++) {
+		Node& node = *nodes[i];
+		int cores = node.scheduler->getNumCores();
+		int used = node.scheduler->getCoresUsed();
+		char row[128];
+		snprintf(row, sizeof(row), "%4d  %5d  %4d  %5.1f%%  %6d  %11zu  %6llu  %11llu  %12llu",
+			i, cores, used, cores == 0 ? 0.0 : 100.0 * used / cores, node.scheduler->getQueuedCount(),
+			node.memoryAllocator->calculateExternalFragmentation(),
+			static_cast<unsigned long long>(node.placed.load()),
+			static_cast<unsigned long long>(node.migratedIn.load()),
+			static_cast<unsigned long long>(node.migratedOut.load()));
+		out << row << "\n";
+	}
+	out << "Cross-node migrations: " << getMigrations() << "\n";
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Screen.h"
+
+using namespace std;
+
+class Scheduler;
+class IMemoryAllocator;
+
+// A cluster of independent nodes, each with its own scheduler (cores, ready
+// queue, clock) and its own simulated memory. Node 0 is the shared Scheduler
+// and IMemoryAllocator instance, so a one-node cluster is the plain emulator.
+//
+// New processes are placed on a node by the cluster-placement policy:
+//   "least-loaded" - node with the fewest ready and running processes per core
+//   "memory"       - least-loaded node whose free memory covers its queued demand
+//                    plus the new process, else the node with the most headroom
+//   "p2c"          - less loaded of two nodes picked at random
+// Once per tick a balancer moves queued processes from the busiest node to the
+// idlest while they differ by at least one process per core.
+class Cluster
+{
+	friend class EmulatorContext;
+
+public:
+	static constexpr int MAX_NODES = 16;
+
+	// Builds every node from the config, including the shared allocator and scheduler of node 0
+	static void initialize(int numNodes);
+	static Cluster* getInstance();
+
+	void start();
+	void stop();
+
+	int getNumNodes() const;
+	Scheduler* getScheduler(int node) const;
+	IMemoryAllocator* getMemoryAllocator(int node) const;
+	bool setNumCores(int numCores);
+
+	// Chooses a node for a new process and queues it there; returns the node
+	int place(shared_ptr<Screen> process);
+	// Moves queued processes off the busiest node; returns how many moved
+	int rebalance();
+
+	int getCoresUsed() const;
+	int getCoresAvailable() const;
+	uint64_t getMigrations() const;
+	void printNodes(ostream& out);
+
+private:
+	struct Node
+	{
+		Scheduler* scheduler;
+		IMemoryAllocator* memoryAllocator;
+		bool owned;  // false for node 0, whose scheduler and allocator are the shared instances
+		std::atomic<uint64_t> placed{ 0 };
+		std::atomic<uint64_t> migratedIn{ 0 };
+		std::atomic<uint64_t> migratedOut{ 0 };
+	};
+
+	Cluster() = default;
+	~Cluster();
+	double getLoad(int node) const;
+	int pickLeastLoaded() const;
+	int pickByMemory(size_t memoryRequired) const;
+	int pickPowerOfTwo();
+	void runBalancer();
+
+	std::vector<std::unique_ptr<Node>> nodes;
+	string placement = "least-loaded";
+	std::atomic<uint64_t> migrations{ 0 };
+	std::atomic<bool> balancing{ false };
+	std::thread balancerThread;
+};
@@ -6,16 +6,29 @@ using namespace std;
 #include <unordered_map>
 #include "Screen.h"
 #include "Colors.h"
+#include "ProcessNameTable.h"
+#include "ProcessTable.h"
+#include "WorkloadRandom.h"
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+#include <climits>
+#include <thread>
+#include "Cluster.h"
+#include "EmulatorContext.h"
 
 
-// stores the created instance of console manager
-ConsoleManager* ConsoleManager::consoleManager = nullptr;
-
 ConsoleManager::ConsoleManager() {
 };
 
+ConsoleManager::~ConsoleManager() {
+    this->stopReplay();
+}
+
+// the instance lives in the emulator context of the calling thread
 void ConsoleManager::initialize() {
-    consoleManager = new ConsoleManager();
+    EmulatorContext::current()->consoleManager = new ConsoleManager();
 }
 
 void ConsoleManager::initializeConfiguration() {
@@ -60,13 +73,64 @@ void ConsoleManager::initializeConfiguration() {
                 ConsoleManager::getInstance()->setBatchProcessFrequency(stoi(value));
             }
             else if (key == "max-overall-mem") {
-                ConsoleManager::getInstance()->setMaxOverallMem(stoi(value));
+                ConsoleManager::getInstance()->setMaxOverallMem(stoull(value));
             }
             else if (key == "mem-per-frame") {
-                ConsoleManager::getInstance()->setMemPerFrame(stoi(value));
+                ConsoleManager::getInstance()->setMemPerFrame(stoull(value));
             }
             else if (key == "mem-per-proc") {
-                ConsoleManager::getInstance()->setMemPerProc(stoi(value));
+                ConsoleManager::getInstance()->setMemPerProc(stoull(value));
+            }
+            else if (key == "min-mem-per-proc") {
+                ConsoleManager::getInstance()->setMinMemPerProc(stoull(value));
+            }
+            else if (key == "max-mem-per-proc") {
+                ConsoleManager::getInstance()->setMaxMemPerProc(stoull(value));
+            }
+            else if (key == "memory-allocator") {
+                value.erase(remove(value.begin(), value.end(), '\"'), value.end()); // Remove quotes
+                ConsoleManager::getInstance()->setMemoryAllocatorConfig(value);
+            }
+            else if (key == "magazine-size") {
+                ConsoleManager::getInstance()->setMagazineSize(stoi(value));
+            }
+            else if (key == "core-pinning") {
+                value.erase(remove(value.begin(), value.end(), '\"'), value.end()); // Remove quotes
+                ConsoleManager::getInstance()->setCorePinning(value);
+            }
+            else if (key == "io-frequency") {
+                ConsoleManager::getInstance()->setIoFrequency(stoi(value));
+            }
+            else if (key == "max-io-ticks") {
+                ConsoleManager::getInstance()->setMaxIoTicks(stoi(value));
+            }
+            else if (key == "aging-ticks") {
+                ConsoleManager::getInstance()->setAgingTicks(stoi(value));
+            }
+            else if (key == "migration-cost") {
+                ConsoleManager::getInstance()->setMigrationCost(stoi(value));
+            }
+            else if (key == "seed") {
+                ConsoleManager::getInstance()->setSeed(stoull(value));
+            }
+            else if (key == "num-nodes") {
+                ConsoleManager::getInstance()->setNumNodes(stoi(value));
+            }
+            else if (key == "cluster-placement") {
+                value.erase(remove(value.begin(), value.end(), '\"'), value.end()); // Remove quotes
+                ConsoleManager::getInstance()->setClusterPlacement(value);
+            }
+            else if (key == "affinity") {
+                value.erase(remove(value.begin(), value.end(), '\"'), value.end()); // Remove quotes
+                ConsoleManager::getInstance()->setAffinity(value);
+            }
+            else if (key == "clock-mode") {
+                value.erase(remove(value.begin(), value.end(), '\"'), value.end()); // Remove quotes
+                ConsoleManager::getInstance()->setClockMode(value);
+            }
+            else if (key == "memory-backing") {
+                value.erase(remove(value.begin(), value.end(), '\"'), value.end()); // Remove quotes
+                ConsoleManager::getInstance()->setMemoryBacking(value);
             }
 
         }
@@ -78,63 +142,185 @@ void ConsoleManager::initializeConfiguration() {
 }
 
 void ConsoleManager::schedulerTest() {
-    static int process_counter = 0;
-    process_counter++;
+    // One process every batch-process-freq CPU ticks, measured on the scheduler's clock
+    Scheduler* scheduler = Scheduler::getInstance();
+    uint64_t frequency = std::max(1, ConsoleManager::getInstance()->getBatchProcessFrequency());
+    uint64_t nextBatch = scheduler->getCpuCycles() + frequency;
+
+    while (scheduler->getSchedulerTestRunning()) {
+        // Short waits so scheduler-stop is noticed even with a long frequency
+        std::lock_guard<std::mutex> batchLock(this->batchMutex);
+        if (!scheduler->waitForTick(nextBatch, std::chrono::milliseconds(100))) {
+            continue;
+        }
+
+        // Skip numbers already taken, e.g. by screen -s P3, so a live process is never replaced
+        string processName;
+        do {
+            this->processCounter++;
+            processName = "P" + std::to_string(this->processCounter);
+        } while (this->findScreen(processName));
+        shared_ptr<BaseScreen> processScreen = make_shared<Screen>(processName, 0, ConsoleManager::getInstance()->getCurrentTimestamp(), ConsoleManager::getInstance()->getRandomMemPerProc(processName));
+        shared_ptr<Screen> screenPtr = static_pointer_cast<Screen>(processScreen);
+        screenPtr->setPriority(this->getRandomPriority(processName));
+        ConsoleManager::getInstance()->registerConsole(processScreen);
+        Cluster::getInstance()->place(screenPtr);
+
+        nextBatch += frequency;
+    }
+}
 
-    while (Scheduler::getInstance()->getSchedulerTestRunning()) {
-        for (int i = 0; i < ConsoleManager::getInstance()->getBatchProcessFrequency(); i++) {
-            /* string processName = "cycle" + std::to_string(ConsoleManager::getInstance()->cpuCycles) + "processName" + std::to_string(i);*/
-            string processName = "P" + std::to_string(process_counter);
-            shared_ptr<BaseScreen> processScreen = make_shared<Screen>(processName, 0, ConsoleManager::getInstance()->getCurrentTimestamp(), ConsoleManager::getInstance()->getMemPerProc());
-            shared_ptr<Screen> screenPtr = static_pointer_cast<Screen>(processScreen);
-            Scheduler::getInstance()->addProcessToQueue(screenPtr);
-            ConsoleManager::getInstance()->registerConsole(processScreen);
-            ConsoleManager::getInstance()->cpuCycles++;
+bool ConsoleManager::startReplay(const string& path, uint64_t scale, string& error) {
+    if (this->replayRunning) {
+        error = "a replay of " + this->replayPath + " is already running";
+        return false;
+    }
+    auto trace = make_shared<WorkloadTrace>();
+    if (!trace->open(path, error)) {
+        return false;
+    }
 
+    // The last replay ended on its own; reap its thread before starting another
+    if (this->replayThread.joinable()) {
+        this->replayThread.join();
+    }
+    this->replay = trace;
+    this->replayPath = path;
+    this->replaySubmitted = 0;
+    this->replayDuplicates = 0;
+    this->replayRunning = true;
+    this->replayThread = EmulatorContext::startThread([this, trace, scale] {
+        this->replayTrace(trace, scale);
+        });
+    return true;
+}
+
+void ConsoleManager::replayTrace(shared_ptr<WorkloadTrace> trace, uint64_t scale) {
+    // Jobs are read as they come due, and arrivals count from the first job on the scheduler's clock
+    Scheduler* scheduler = Scheduler::getInstance();
+    uint64_t start = scheduler->getCpuCycles();
+    uint64_t firstArrival = 0;
+    bool first = true;
+    WorkloadTrace::Job job;
+
+    while (this->replayRunning && trace->next(job)) {
+        if (first) {
+            firstArrival = job.arrival;
+            first = false;
+        }
+        // A job listed out of order arrives as soon as it is read
+        uint64_t due = start + (job.arrival - std::min(job.arrival, firstArrival)) / scale;
+        while (this->replayRunning && !scheduler->waitForTick(due, std::chrono::milliseconds(100))) {
+        }
+        if (!this->replayRunning) {
+            break;
+        }
 
+        std::lock_guard<std::mutex> batchLock(this->batchMutex);
+        if (this->findScreen(job.name)) {
+            this->replayDuplicates++;
+            continue;
         }
-        process_counter++;
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        // Unknown memory and priority come from the seeded streams, like generated processes
+        int totalLine = static_cast<int>(std::clamp<uint64_t>(job.instructions / scale, 1, INT_MAX));
+        size_t memory = job.memory > 0 ? static_cast<size_t>(job.memory) : this->getRandomMemPerProc(job.name);
+        memory = std::max<size_t>(1, std::min(memory, this->maxOverallMem));
+        auto screen = make_shared<Screen>(job.name, this->getCurrentTimestamp(), memory, totalLine, Screen::generateBlocking(job.name, totalLine));
+        screen->setPriority(job.priority >= 0 ? job.priority : this->getRandomPriority(job.name));
+        this->registerConsole(screen);
+        Cluster::getInstance()->place(screen);
+        this->replaySubmitted++;
     }
+    this->replayRunning = false;
+}
+
+void ConsoleManager::stopReplay() {
+    // The thread notices within one 100 ms clock wait
+    this->replayRunning = false;
+    if (this->replayThread.joinable()) {
+        this->replayThread.join();
+    }
+}
+
+bool ConsoleManager::isReplayRunning() {
+    return this->replayRunning;
+}
+
+void ConsoleManager::printReplayStatus(ostream& out) {
+    if (!this->replay) {
+        out << "No trace has been replayed." << std::endl;
+        return;
+    }
+    const char* format = this->replay->getFormat() == WorkloadTrace::SWF ? "SWF" : "CSV";
+    out << "Replay of " << this->replayPath << " (" << format << "): " << (this->replayRunning ? "running" : "done")
+        << ", " << this->replaySubmitted << " jobs submitted, " << this->replay->getSkipped() << " lines skipped, "
+        << this->replayDuplicates << " duplicate names skipped" << std::endl;
+}
+
+std::unique_lock<std::mutex> ConsoleManager::pauseBatchGeneration() {
+    return std::unique_lock<std::mutex>(this->batchMutex);
+}
+
+int ConsoleManager::getProcessCounter() {
+    return this->processCounter;
+}
+
+void ConsoleManager::setProcessCounter(int processCounter) {
+    this->processCounter = processCounter;
 }
 
-int ConsoleManager::getCpuCycles() {
-    return this->cpuCycles;
+uint64_t ConsoleManager::getCpuCycles() {
+    return Scheduler::getInstance()->getCpuCycles();
 }
 
 void ConsoleManager::drawConsole() {
+    if (this->batchMode) {
+        return;
+    }
+
     if (this->switchSuccessful) {
-        system("cls");
+        this->clearScreen();
         string consoleName = this->getCurrentConsole()->getConsoleName();
 
         if (this->getCurrentConsole()->getConsoleName() == MAIN_CONSOLE) {
             this->printHeader();
         }
         else {
-            if (this->screenMap.contains(consoleName)) {
-                cout << "Screen Name: " << this->screenMap[consoleName]->getConsoleName() << endl;
-                cout << "Current line of instruction / Total line of instruction: ";
-                cout << this->screenMap[consoleName]->getCurrentLine();
-                cout << "/" << this->screenMap[consoleName]->getTotalLine() << endl;
-                cout << "Timestamp: " << this->screenMap[consoleName]->getTimestamp() << endl;
+            shared_ptr<BaseScreen> screen = this->getCurrentConsole();
+            int currentLine = screen->getCurrentLine();
+            int totalLine = screen->getTotalLine();
+            if (shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(screen)) {
+                ProcessTable::Snapshot snapshot = screenPtr->getSnapshot();
+                currentLine = snapshot.currentLine;
+                totalLine = snapshot.totalLine;
             }
+            cout << "Screen Name: " << screen->getConsoleName() << endl;
+            cout << "Current line of instruction / Total line of instruction: ";
+            cout << currentLine;
+            cout << "/" << totalLine << endl;
+            cout << "Timestamp: " << screen->getTimestamp() << endl;
         }
     }
 }
 
 void ConsoleManager::destroy() {
-    consoleManager->scheduler.stop(); // Stop the scheduler
-    delete consoleManager;
+    EmulatorContext* context = EmulatorContext::current();
+    context->consoleManager->scheduler.stop(); // Stop the scheduler
+    delete context->consoleManager;
+    context->consoleManager = nullptr;
 }
 
 string ConsoleManager::getCurrentTimestamp() {
     // Get current time as time_t object
-    time_t currentTime = time(nullptr);
+    return this->formatTimestamp(time(nullptr));
+}
+
+string ConsoleManager::formatTimestamp(time_t time) {
     // Create tm structure to store local time
     tm localTime;
     // Convert time_t to tm structure 
-    localtime_s(&localTime, &currentTime);
+    localtime_s(&localTime, &time);
     // Create a buffer to store the formatted time
     char timeBuffer[100];
     // Format the time (MM/DD/YYYY, HH:MM:SS AM/PM)
@@ -143,14 +329,17 @@ string ConsoleManager::getCurrentTimestamp() {
 }
 
 void ConsoleManager::registerConsole(shared_ptr<BaseScreen> screenRef) {
-    this->screenMap[screenRef->getConsoleName()] = screenRef; //it should accept MainScreen and ProcessScreen
+    int pid = ProcessNameTable::getInstance()->intern(screenRef->getConsoleName());
+    std::lock_guard<std::mutex> lock(this->screenMapMutex);
+    this->screenMap[pid] = screenRef; //it should accept MainScreen and ProcessScreen
     //system("cls");
 }
 
 void ConsoleManager::switchConsole(string consoleName)
 {
-    if (this->screenMap.contains(consoleName)) {
-        this->currentConsole = this->screenMap[consoleName];
+    shared_ptr<BaseScreen> screen = this->findScreen(consoleName);
+    if (screen) {
+        this->currentConsole = screen;
         this->consoleName = consoleName;
 
         if (consoleName == MAIN_CONSOLE) {
@@ -165,101 +354,234 @@ void ConsoleManager::switchConsole(string consoleName)
     }
 }
 
-void ConsoleManager::displayProcessList() {
-    unordered_map<string, shared_ptr<BaseScreen>> screenMap = ConsoleManager::getInstance()->getScreenMap();
+void ConsoleManager::collectProcessLists(vector<ProcessTable::Snapshot>& running, vector<ProcessTable::Snapshot>& finished, const ProcessListOptions& options) {
+    // Start from the state/core indexes so only matching processes are visited; each
+    // row is a seqlock snapshot so the line counts, core and state printed always belong together
+    ProcessTable* table = ProcessTable::getInstance();
+    vector<int> pids;
+    if (options.coreId >= 0) {
+        pids = table->getPidsOnCore(options.coreId);
+    }
+    else {
+        if (options.showRunning) {
+            for (ProcessTable::State state : { ProcessTable::READY, ProcessTable::RUNNING, ProcessTable::WAITING }) {
+                vector<int> members = table->getPidsInState(state);
+                pids.insert(pids.end(), members.begin(), members.end());
+            }
+        }
+        if (options.showFinished) {
+            vector<int> members = table->getPidsInState(ProcessTable::FINISHED);
+            pids.insert(pids.end(), members.begin(), members.end());
+        }
+    }
+    // A process that changed state while the indexes were copied can be listed twice
+    std::sort(pids.begin(), pids.end());
+    pids.erase(std::unique(pids.begin(), pids.end()), pids.end());
+
+    for (int pid : pids) {
+        ProcessTable::Snapshot snapshot = table->getSnapshot(pid);
+        if (snapshot.state == ProcessTable::NOT_A_PROCESS) {
+            continue;
+        }
+        if (snapshot.state == ProcessTable::FINISHED) {
+            if (options.showFinished) {
+                finished.push_back(snapshot);
+            }
+        }
+        else if (options.showRunning) {
+            running.push_back(snapshot);
+        }
+    }
+
+    this->sortProcessList(running, options);
+    this->sortProcessList(finished, options);
+}
+
+void ConsoleManager::sortProcessList(vector<ProcessTable::Snapshot>& processes, const ProcessListOptions& options) {
+    std::function<bool(const ProcessTable::Snapshot&, const ProcessTable::Snapshot&)> before;
+    if (options.sortKey == "name") {
+        before = [](const ProcessTable::Snapshot& a, const ProcessTable::Snapshot& b) {
+            return ProcessNameTable::getInstance()->getName(a.pid) < ProcessNameTable::getInstance()->getName(b.pid);
+        };
+    }
+    else if (options.sortKey == "progress") {
+        // Furthest along first
+        before = [](const ProcessTable::Snapshot& a, const ProcessTable::Snapshot& b) {
+            return (int64_t)a.currentLine * b.totalLine > (int64_t)b.currentLine * a.totalLine;
+        };
+    }
+    else if (options.sortKey == "remaining") {
+        // Closest to finishing first
+        before = [](const ProcessTable::Snapshot& a, const ProcessTable::Snapshot& b) {
+            return a.totalLine - a.currentLine < b.totalLine - b.currentLine;
+        };
+    }
+    else {
+        before = [](const ProcessTable::Snapshot& a, const ProcessTable::Snapshot& b) {
+            return a.pid < b.pid;
+        };
+    }
+
+    // Only the rows that will be printed need to be ordered
+    if (options.top >= 0 && options.top < static_cast<int>(processes.size())) {
+        std::partial_sort(processes.begin(), processes.begin() + options.top, processes.end(), before);
+        processes.resize(options.top);
+    }
+    else {
+        std::sort(processes.begin(), processes.end(), before);
+    }
+}
+
+void ConsoleManager::displayProcessList(const ProcessListOptions& options) {
     Scheduler* scheduler = Scheduler::getInstance();
-    int coresUsed = scheduler->getCoresUsed();
-    int coresAvailable = scheduler->getCoresAvailable();
+    int coresUsed = Cluster::getInstance()->getCoresUsed();
+    int coresAvailable = Cluster::getInstance()->getCoresAvailable();
     float cpuUtilization = (float)coresUsed / (coresUsed + coresAvailable) * 100;
 
-    cout << "\nCPU Utilization: " << cpuUtilization << "%" << endl;
-    cout << "Cores used: " << coresUsed << endl;
-    cout << "Cores available: " << coresAvailable << endl;
-    cout << BLUE << "-----------------------------------" << RESET << endl;
-    cout << "Running processes:" << endl;
-    for (const auto& pair : screenMap) {
-        shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(pair.second);
+    // Built in memory and written at once, so the listing is not flushed line by line
+    std::ostringstream out;
+    vector<ProcessTable::Snapshot> running;
+    vector<ProcessTable::Snapshot> finished;
+    this->collectProcessLists(running, finished, options);
+
+    out << "\nCPU Utilization: " << cpuUtilization << "%" << "\n";
+    out << "CPU cycles: " << scheduler->getCpuCycles() << "\n";
+    out << "Cores used: " << coresUsed << "\n";
+    out << "Cores available: " << coresAvailable << "\n";
+    out << BLUE << "-----------------------------------" << RESET << "\n";
+    if (options.showRunning) {
+        out << "Running processes:" << "\n";
+    }
+    for (const ProcessTable::Snapshot& snapshot : running) {
+        // Every pid in the process table belongs to a Screen
+        shared_ptr<Screen> screenPtr = static_pointer_cast<Screen>(this->getScreen(snapshot.pid));
 
-        if (screenPtr && !screenPtr->isFinished()) {
+        if (screenPtr) {
 
-            auto coreID = screenPtr->getCPUCoreID();
+            auto coreID = snapshot.coreId;
             string coreIDstr;
-            if (coreID == -1) {
+            if (snapshot.state == ProcessTable::WAITING) {
+                coreIDstr = "Waiting";
+            }
+            else if (coreID == -1) {
                 coreIDstr = "N/A";
             }
             else {
                 coreIDstr = to_string(coreID);
             }
 
-            cout << "Name: " << screenPtr->getProcessName() << BLUE << " (" << RESET << YELLOW
+            out << "Name: " << screenPtr->getProcessName() << BLUE << " (" << RESET << YELLOW
                 << screenPtr->getTimestamp() << RESET << BLUE << ") " << RESET
                 << "Core" << BLUE << ": " << RESET << YELLOW << coreIDstr << "   "
-                << screenPtr->getCurrentLine() << RESET << BLUE << "/"
-                << YELLOW << screenPtr->getTotalLine() << "   " << RESET << endl;
+                << snapshot.currentLine << RESET << BLUE << "/"
+                << YELLOW << snapshot.totalLine << "   " << RESET << "\n";
         }
     }
 
-    cout << "\nFinished processes:" << endl;
-    for (const auto& pair : screenMap) {
-        shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(pair.second);
+    if (options.showFinished) {
+        out << (options.showRunning ? "\n" : "") << "Finished processes:" << "\n";
+    }
+    for (const ProcessTable::Snapshot& snapshot : finished) {
+        shared_ptr<Screen> screenPtr = static_pointer_cast<Screen>(this->getScreen(snapshot.pid));
 
 
-        if (screenPtr && screenPtr->isFinished()) {
-            cout << "Name: " << screenPtr->getProcessName() << BLUE << " (" << RESET << YELLOW
+        if (screenPtr) {
+            out << "Name: " << screenPtr->getProcessName() << BLUE << " (" << RESET << YELLOW
                 << screenPtr->getTimestamp() << RESET << BLUE << ") " << RESET
                 << "   " << "Finished" << "   "
-                << YELLOW << screenPtr->getCurrentLine() << RESET << BLUE << "/" << RESET
-                << YELLOW << screenPtr->getTotalLine() << RESET << "   " << endl;
+                << YELLOW << snapshot.currentLine << RESET << BLUE << "/" << RESET
+                << YELLOW << snapshot.totalLine << RESET << "   " << "\n";
         }
     }
-    cout << BLUE << "-----------------------------------" << RESET << endl;
+    out << BLUE << "-----------------------------------" << RESET << "\n";
+    cout << out.str() << flush;
+}
+
+void ConsoleManager::printWaitStats(ostream& out) {
+    // Ticks spent in the ready queue before each dispatch, by base priority
+    Scheduler* scheduler = Scheduler::getInstance();
+    out << "Ready-queue wait by priority (ticks)" << (scheduler->isPrioritized() ? "" : ", priorities not used by this scheduler") << std::endl;
+    out << "Priority  Dispatches  Avg wait  Max wait" << std::endl;
+    for (int priority = Screen::HIGHEST_PRIORITY; priority <= Screen::LOWEST_PRIORITY; priority++) {
+        Scheduler::WaitStats stats = scheduler->getWaitStats(priority);
+        if (stats.dispatches == 0) {
+            continue;
+        }
+        char row[96];
+        snprintf(row, sizeof(row), "%8d  %10llu  %8.1f  %8llu", priority, static_cast<unsigned long long>(stats.dispatches),
+            static_cast<double>(stats.totalWait) / stats.dispatches, static_cast<unsigned long long>(stats.maxWait));
+        out << row << std::endl;
+    }
+}
+
+void ConsoleManager::printAffinityStats(ostream& out) {
+    Scheduler* scheduler = Scheduler::getInstance();
+    Scheduler::AffinityStats stats = scheduler->getAffinityStats();
+    double migrationRate = stats.dispatches == 0 ? 0.0 : 100.0 * stats.migrations / stats.dispatches;
+    char line[160];
+    snprintf(line, sizeof(line), "Core affinity (%s, migration cost %d): %llu of %llu re-dispatches migrated (%.1f%%), %llu stall ticks, %llu affinity picks",
+        scheduler->isSoftAffinity() ? "soft" : "off", this->migrationCost,
+        static_cast<unsigned long long>(stats.migrations), static_cast<unsigned long long>(stats.dispatches), migrationRate,
+        static_cast<unsigned long long>(stats.stallTicks), static_cast<unsigned long long>(stats.affinityPicks));
+    out << line << std::endl;
 }
 
 void ConsoleManager::reportUtil() {
     std::ostringstream logStream;
-    unordered_map<string, shared_ptr<BaseScreen>> screenMap = ConsoleManager::getInstance()->getScreenMap();
     Scheduler* scheduler = Scheduler::getInstance();
-    int coresUsed = scheduler->getCoresUsed();
-    int coresAvailable = scheduler->getCoresAvailable();
+    int coresUsed = Cluster::getInstance()->getCoresUsed();
+    int coresAvailable = Cluster::getInstance()->getCoresAvailable();
     float cpuUtilization = static_cast<float>(coresUsed) / (coresUsed + coresAvailable) * 100;
 
+    vector<ProcessTable::Snapshot> running;
+    vector<ProcessTable::Snapshot> finished;
+    this->collectProcessLists(running, finished);
+
     // Log CPU utilization and core details
     logStream << "\nCPU Utilization: " << cpuUtilization << "%" << std::endl;
+    logStream << "CPU cycles: " << scheduler->getCpuCycles() << std::endl;
     logStream << "Cores used: " << coresUsed << std::endl;
     logStream << "Cores available: " << coresAvailable << std::endl;
     logStream << "-----------------------------------" << std::endl;
     logStream << "Running processes:" << std::endl;
 
     // Log details of running processes
-    for (const auto& pair : screenMap) {
-        auto screenPtr = std::dynamic_pointer_cast<Screen>(pair.second);
-        if (screenPtr && !screenPtr->isFinished()) {
-            auto coreID = screenPtr->getCPUCoreID();
-            std::string coreIDstr = (coreID == -1) ? "N/A" : std::to_string(coreID);
+    for (const ProcessTable::Snapshot& snapshot : running) {
+        auto screenPtr = std::dynamic_pointer_cast<Screen>(this->getScreen(snapshot.pid));
+        if (screenPtr) {
+            auto coreID = snapshot.coreId;
+            std::string coreIDstr = (snapshot.state == ProcessTable::WAITING) ? "Waiting" : (coreID == -1) ? "N/A" : std::to_string(coreID);
 
             logStream << "Name: " << screenPtr->getProcessName() << " | "
                 << screenPtr->getTimestamp() << " | "
                 << "Core: " << coreIDstr << " | "
-                << screenPtr->getCurrentLine() << "/"
-                << screenPtr->getTotalLine() << " | " << std::endl;
+                << snapshot.currentLine << "/"
+                << snapshot.totalLine << " | " << std::endl;
         }
     }
 
     logStream << "\nFinished processes:" << std::endl;
 
     // Log details of finished processes
-    for (const auto& pair : screenMap) {
-        auto screenPtr = std::dynamic_pointer_cast<Screen>(pair.second);
-        if (screenPtr && screenPtr->isFinished()) {
+    for (const ProcessTable::Snapshot& snapshot : finished) {
+        auto screenPtr = std::dynamic_pointer_cast<Screen>(this->getScreen(snapshot.pid));
+        if (screenPtr) {
+            // the finish time can lag the last line by a moment; fall back to the creation time
+            string finishedAt = snapshot.finishedAt != 0 ? this->formatTimestamp(static_cast<time_t>(snapshot.finishedAt)) : screenPtr->getTimestamp();
             logStream << "Name: " << screenPtr->getProcessName() << " | "
-                << screenPtr->getTimestampFinished() << " | "
+                << finishedAt << " | "
                 << "Finished" << " | "
-                << screenPtr->getCurrentLine() << "/"
-                << screenPtr->getTotalLine() << " | " << std::endl;
+                << snapshot.currentLine << "/"
+                << snapshot.totalLine << " | " << std::endl;
         }
     }
 
     logStream << "-----------------------------------" << std::endl;
+    this->printWaitStats(logStream);
+    this->printAffinityStats(logStream);
+    if (Cluster::getInstance()->getNumNodes() > 1) {
+        Cluster::getInstance()->printNodes(logStream);
+    }
 
     // Write the log data to a file
     std::ofstream file("text_files/csopesy-log.txt", std::ios::out);
@@ -333,63 +655,65 @@ void ConsoleManager::setDelayPerExec(int delayPerExec) {
 
 
 void ConsoleManager::printProcess(string enteredProcess) {
-    unordered_map<string, shared_ptr<BaseScreen>> screenMap = ConsoleManager::getInstance()->getScreenMap();
-    auto it = screenMap.find(enteredProcess);
+    shared_ptr<BaseScreen> screen = this->findScreen(enteredProcess);
 
-    if (it == screenMap.end()) {
+    if (!screen) {
         cout << RED << "Process: '" << enteredProcess << "' not found." << RESET << endl;
         return;
     }
-    shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(it->second);
+    shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(screen);
     if (!screenPtr) {
         cout << RED << "Screen '" << enteredProcess << "' is not a process screen." << RESET << endl;
         return;
     }
 
-    for (const auto& pair : screenMap) {
-        shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(pair.second);
-
-        //check if process name exits
-        if (screenPtr->getProcessName() == enteredProcess) {
-
-            //check if process is finished
-            if (screenPtr && screenPtr->isFinished()) {
-                shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(screenMap.find(enteredProcess)->second);
-
-                auto coreID = screenPtr->getCPUCoreID();
-                string coreIDstr;
-                if (coreID == -1) {
-                    coreIDstr = "N/A";
-                }
-                else {
-                    coreIDstr = to_string(coreID);
-                }
-
-                cout << BLUE << "Process Name: " << enteredProcess << endl;
-                cout << "Logs:" << endl;
-                cout << "(" << screenPtr->getTimestamp() << ")  "
-                    << "Core: " << coreIDstr << "  " << RESET;
-                //where to put createfile?
-                screenPtr->createFile();
-                screenPtr->viewFile();
-            }
-            else {
-                cout << RED << "Process is not yet finished" << RESET << endl;
-            }
-
+    //check if process is finished
+    if (screenPtr->isFinished()) {
+        auto coreID = screenPtr->getCPUCoreID();
+        string coreIDstr;
+        if (coreID == -1) {
+            coreIDstr = "N/A";
+        }
+        else {
+            coreIDstr = to_string(coreID);
         }
 
+        cout << BLUE << "Process Name: " << enteredProcess << endl;
+        cout << "Logs:" << endl;
+        cout << "(" << screenPtr->getTimestamp() << ")  "
+            << "Core: " << coreIDstr << "  " << RESET;
+        //where to put createfile?
+        screenPtr->createFile();
+        screenPtr->viewFile();
+    }
+    else {
+        cout << RED << "Process is not yet finished" << RESET << endl;
     }
 }
 
 void ConsoleManager::printProcessSmi() {
+    shared_ptr<BaseScreen> screen = this->getCurrentConsole();
+    int currentLine = screen->getCurrentLine();
+    int totalLine = screen->getTotalLine();
+    if (shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(screen)) {
+        ProcessTable::Snapshot snapshot = screenPtr->getSnapshot();
+        currentLine = snapshot.currentLine;
+        totalLine = snapshot.totalLine;
+    }
     cout << "Process: " << this->consoleName << endl;
-    if (this->screenMap[consoleName]->getCurrentLine() == this->screenMap[consoleName]->getTotalLine()) {
+    if (shared_ptr<Screen> screenPtr = dynamic_pointer_cast<Screen>(screen)) {
+        cout << "Priority: " << screenPtr->getPriority() << endl;
+        cout << "Core migrations: " << screenPtr->getMigrations() << endl;
+        if (Cluster::getInstance()->getNumNodes() > 1) {
+            cout << "Node: " << screenPtr->getNode() << endl;
+        }
+    }
+    if (currentLine == totalLine) {
         cout << "Finished!" << endl;
     }
     else {
-        cout << "Current Line: " << this->screenMap[consoleName]->getCurrentLine() << endl;
-        cout << "Lines of Code: " << this->screenMap[consoleName]->getTotalLine() << endl;
+        cout << "Current Line: " << currentLine << endl;
+        cout << "Lines of Code: " << totalLine << endl;
     }
 
 }
@@ -406,22 +730,57 @@ void ConsoleManager::setCurrentConsole(shared_ptr<BaseScreen> screenRef)
 
 ConsoleManager* ConsoleManager::getInstance()
 {
-    return consoleManager;
+    return EmulatorContext::current()->consoleManager;
 }
 
 void ConsoleManager::exitApplication() {
     this->running = false;
-    Scheduler::getInstance()->stop();
+    this->stopReplay();
+    Cluster::getInstance()->stop();
 }
 
 bool ConsoleManager::isRunning() {
     return this->running;
 }
 
-unordered_map<string, shared_ptr<BaseScreen>> ConsoleManager::getScreenMap() {
+void ConsoleManager::setBatchMode(bool batchMode) {
+    this->batchMode = batchMode;
+}
+
+bool ConsoleManager::isBatchMode() {
+    return this->batchMode;
+}
+
+void ConsoleManager::clearScreen() {
+    // Clears and homes the cursor with ANSI codes instead of spawning a shell for cls
+    if (!this->batchMode) {
+        cout << "\033[2J\033[H" << flush;
+    }
+}
+
+unordered_map<int, shared_ptr<BaseScreen>> ConsoleManager::getScreenMap() {
+    std::lock_guard<std::mutex> lock(this->screenMapMutex);
     return this->screenMap;
 }
 
+shared_ptr<BaseScreen> ConsoleManager::getScreen(int pid) {
+    std::lock_guard<std::mutex> lock(this->screenMapMutex);
+    auto it = this->screenMap.find(pid);
+    return (it != this->screenMap.end()) ? it->second : nullptr;
+}
+
+shared_ptr<BaseScreen> ConsoleManager::findScreen(const string& name) {
+    // Names are resolved to a pid once; the table itself is keyed by pid
+    int pid = ProcessNameTable::getInstance()->findPid(name);
+    if (pid == ProcessNameTable::NO_PID) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(this->screenMapMutex);
+    auto it = this->screenMap.find(pid);
+    return (it != this->screenMap.end()) ? it->second : nullptr;
+}
+
 void ConsoleManager::setInitialized(bool initialized) {
     this->initialized = initialized;
 }
@@ -454,6 +813,163 @@ size_t ConsoleManager::getMemPerProc() {
     return this->memPerProc;
 }
 
+void ConsoleManager::setMinMemPerProc(size_t minMemPerProc) {
+    this->minMemPerProc = minMemPerProc;
+}
+
+void ConsoleManager::setMaxMemPerProc(size_t maxMemPerProc) {
+    this->maxMemPerProc = maxMemPerProc;
+}
+
+size_t ConsoleManager::getMinMemPerProc() {
+    return this->minMemPerProc;
+}
+
+size_t ConsoleManager::getMaxMemPerProc() {
+    return this->maxMemPerProc;
+}
+
+void ConsoleManager::setMemoryAllocatorConfig(string memoryAllocatorConfig) {
+    this->memoryAllocatorConfig = memoryAllocatorConfig;
+}
+
+string ConsoleManager::getMemoryAllocatorConfig() {
+    return this->memoryAllocatorConfig;
+}
+
+void ConsoleManager::setMagazineSize(size_t magazineSize) {
+    this->magazineSize = magazineSize;
+}
+
+size_t ConsoleManager::getMagazineSize() {
+    return this->magazineSize;
+}
+
+void ConsoleManager::setCorePinning(string corePinning) {
+    this->corePinning = corePinning;
+}
+
+string ConsoleManager::getCorePinning() {
+    return this->corePinning;
+}
+
+void ConsoleManager::setClockMode(string clockMode) {
+    this->clockMode = clockMode;
+}
+
+string ConsoleManager::getClockMode() {
+    return this->clockMode;
+}
+
+void ConsoleManager::setMemoryBacking(string memoryBacking) {
+    this->memoryBacking = memoryBacking;
+}
+
+string ConsoleManager::getMemoryBacking() {
+    return this->memoryBacking;
+}
+
+void ConsoleManager::setMemoryStamps(bool memoryStamps) {
+    this->memoryStamps = memoryStamps;
+}
+
+bool ConsoleManager::getMemoryStamps() {
+    return this->memoryStamps;
+}
+
+void ConsoleManager::setIoFrequency(int ioFrequency) {
+    this->ioFrequency = ioFrequency;
+}
+
+int ConsoleManager::getIoFrequency() {
+    return this->ioFrequency;
+}
+
+void ConsoleManager::setMaxIoTicks(int maxIoTicks) {
+    this->maxIoTicks = maxIoTicks;
+}
+
+int ConsoleManager::getMaxIoTicks() {
+    return this->maxIoTicks;
+}
+
+void ConsoleManager::setAgingTicks(int agingTicks) {
+    this->agingTicks = agingTicks;
+}
+
+int ConsoleManager::getAgingTicks() {
+    return this->agingTicks;
+}
+
+void ConsoleManager::setMigrationCost(int migrationCost) {
+    this->migrationCost = migrationCost;
+}
+
+int ConsoleManager::getMigrationCost() {
+    return this->migrationCost;
+}
+
+void ConsoleManager::setAffinity(string affinity) {
+    this->affinity = affinity;
+}
+
+string ConsoleManager::getAffinity() {
+    return this->affinity;
+}
+
+void ConsoleManager::setNumNodes(int numNodes) {
+    this->numNodes = numNodes;
+}
+
+int ConsoleManager::getNumNodes() {
+    return this->numNodes;
+}
+
+void ConsoleManager::setClusterPlacement(string clusterPlacement) {
+    this->clusterPlacement = clusterPlacement;
+}
+
+string ConsoleManager::getClusterPlacement() {
+    return this->clusterPlacement;
+}
+
+size_t ConsoleManager::getRandomMemPerProc(const string& processName) {
+    // Fall back to the fixed mem-per-proc when no range is configured
+    if (this->minMemPerProc == 0 || this->maxMemPerProc == 0 || this->minMemPerProc > this->maxMemPerProc) {
+        return this->memPerProc;
+    }
+
+    // Memory requirements are powers of two within [min-mem-per-proc, max-mem-per-proc]
+    size_t lowest = 1;
+    while (lowest < this->minMemPerProc) {
+        lowest <<= 1;
+    }
+    vector<size_t> sizes;
+    for (size_t size = lowest; size <= this->maxMemPerProc; size <<= 1) {
+        sizes.push_back(size);
+    }
+    if (sizes.empty()) {
+        return this->minMemPerProc;
+    }
+
+    WorkloadRandom random(WorkloadRandom::MEMORY_SIZE, processName);
+    return sizes[random.uniform(uint64_t(0), uint64_t(sizes.size() - 1))];
+}
+
+int ConsoleManager::getRandomPriority(const string& processName) {
+    // Generated load is background work, below the default priority of screen -s
+    WorkloadRandom random(WorkloadRandom::PRIORITY, processName);
+    return random.uniform(Screen::HIGHEST_PRIORITY + 1, Screen::LOWEST_PRIORITY);
+}
+
+void ConsoleManager::setSeed(uint64_t seed) {
+    this->seed = seed;
+}
+
+uint64_t ConsoleManager::getSeed() {
+    return this->seed;
+}
+
 void ConsoleManager::printHeader() {
     cout << PASTEL_PINK << "________________________________________________________________________________\n";
     cout << " ,-----. ,---.   ,-----. ,------. ,------. ,---.,--.   ,--. \n";
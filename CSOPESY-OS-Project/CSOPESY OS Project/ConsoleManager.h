@@ -2,12 +2,26 @@
 #include "Screen.h"
 #include <unordered_map>
 #include "Scheduler.h"
+#include "WorkloadTrace.h"
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <mutex>
+#include <atomic>
+#include <thread>
 
 const string MAIN_CONSOLE = "MAIN_CONSOLE";
 
+// Filters for screen -ls: --running, --finished, --core N, --sort KEY, --top N
+struct ProcessListOptions
+{
+	bool showRunning = true;
+	bool showFinished = true;
+	int coreId = -1;  // -1 lists every core
+	string sortKey = "pid";  // pid, name, progress or remaining
+	int top = -1;  // -1 lists everything
+};
+
 class ConsoleManager
 {
 public:
@@ -21,6 +35,8 @@ public:
 
 	// default constructor
 	ConsoleManager();
+	// Stops and joins a replay still running
+	~ConsoleManager();
 
 	// we can run this to create a console manager pointer
 	static void initialize();
@@ -32,7 +48,10 @@ public:
 	void drawConsole();
 	void destroy();
 	string getCurrentTimestamp();
-	std::unordered_map<string, std::shared_ptr<BaseScreen>> getScreenMap();
+	string formatTimestamp(time_t time);
+	std::unordered_map<int, std::shared_ptr<BaseScreen>> getScreenMap();
+	std::shared_ptr<BaseScreen> findScreen(const string& name);
+	std::shared_ptr<BaseScreen> getScreen(int pid);
 
 	void registerConsole(std::shared_ptr<BaseScreen> screenRef);
 	void switchConsole(string consoleName);
@@ -52,6 +71,22 @@ public:
 	void setMaxOverallMem(size_t maxOverallMem);
 	void setMemPerFrame(size_t memPerFrame);
 	void setMemPerProc(size_t memPerProc);
+	void setMinMemPerProc(size_t minMemPerProc);
+	void setMaxMemPerProc(size_t maxMemPerProc);
+	void setMemoryAllocatorConfig(string memoryAllocatorConfig);
+	void setMagazineSize(size_t magazineSize);
+	void setCorePinning(string corePinning);
+	void setIoFrequency(int ioFrequency);
+	void setMaxIoTicks(int maxIoTicks);
+	void setAgingTicks(int agingTicks);
+	void setMigrationCost(int migrationCost);
+	void setAffinity(string affinity);
+	void setNumNodes(int numNodes);
+	void setSeed(uint64_t seed);
+	void setClusterPlacement(string clusterPlacement);
+	void setClockMode(string clockMode);
+	void setMemoryBacking(string memoryBacking);
+	void setMemoryStamps(bool memoryStamps);
 
 	int getNumCpu();
 	string getSchedulerConfig();
@@ -61,27 +96,63 @@ public:
 	int getMaxIns();
 	int getDelayPerExec();
 	void printProcessSmi();
-	int getCpuCycles();
+	uint64_t getCpuCycles();
 	size_t getMaxOverallMem();
 	size_t getMemPerFrame();
 	size_t getMemPerProc();
+	size_t getMinMemPerProc();
+	size_t getMaxMemPerProc();
+	// Drawn from the process's own seeded streams, so a name always gets the same values
+	size_t getRandomMemPerProc(const string& processName);
+	int getRandomPriority(const string& processName);
+	string getMemoryAllocatorConfig();
+	size_t getMagazineSize();
+	string getCorePinning();
+	int getIoFrequency();
+	int getMaxIoTicks();
+	int getAgingTicks();
+	int getMigrationCost();
+	string getAffinity();
+	int getNumNodes();
+	uint64_t getSeed();
+	string getClusterPlacement();
+	string getClockMode();
+	string getMemoryBacking();
+	bool getMemoryStamps();
 
 	void exitApplication();
 	bool isRunning();
+	// Batch mode runs scripted commands without clearing the screen or redrawing consoles
+	void setBatchMode(bool batchMode);
+	bool isBatchMode();
+	void clearScreen();
 	void setCurrentConsole(std::shared_ptr<BaseScreen> screenRef);
-	void displayProcessList();
+	void collectProcessLists(vector<ProcessTable::Snapshot>& running, vector<ProcessTable::Snapshot>& finished, const ProcessListOptions& options = ProcessListOptions());
+	void sortProcessList(vector<ProcessTable::Snapshot>& processes, const ProcessListOptions& options);
+	void displayProcessList(const ProcessListOptions& options = ProcessListOptions());
 	void reportUtil();
+	void printWaitStats(ostream& out);
+	void printAffinityStats(ostream& out);
 	void printProcess(string enteredProcess);
 	void schedulerTest();
+	// Creates the jobs of a trace as the clock reaches their arrival; times and lengths are divided by scale
+	void replayTrace(shared_ptr<WorkloadTrace> trace, uint64_t scale);
+	bool startReplay(const string& path, uint64_t scale, string& error);
+	void stopReplay();  // returns once the replay thread has exited
+	bool isReplayRunning();
+	void printReplayStatus(ostream& out);
+	// Holds off batch process creation while a checkpoint is written or restored
+	std::unique_lock<std::mutex> pauseBatchGeneration();
+	int getProcessCounter();
+	void setProcessCounter(int processCounter);
 
 
 private:
-	// stores the console manager pointer so that we only instantiate once
-	static ConsoleManager* consoleManager;
 	string consoleName = "";
 	bool running = true;
 	bool switchSuccessful = true;
 	bool initialized = false;
+	std::atomic<bool> batchMode{ false };
 	int num_cpu = 0;
 	string schedulerConfig = "";
 	int timeSlice = 0;
@@ -89,16 +160,40 @@ private:
 	int minIns = 0;
 	int maxIns = 0;
 	int delayPerExec = 0;
-	int cpuCycles = 0;
 	size_t maxOverallMem = 0;
 	size_t memPerFrame = 0;
 	size_t memPerProc = 0;
+	size_t minMemPerProc = 0;
+	size_t maxMemPerProc = 0;
+	string memoryAllocatorConfig = "flat";
+	size_t magazineSize = 0;
+	string corePinning = "off";
+	int ioFrequency = 0;
+	int maxIoTicks = 0;
+	int agingTicks = 20;  // priority scheduler: ticks in the ready queue per level of aging
+	int migrationCost = 0;  // instruction times a process stalls after moving to another core
+	string affinity = "off";  // or "soft" to prefer dispatching processes on their last core
+	int numNodes = 1;
+	uint64_t seed = 0;  // workload seed; 0 picks a new one on every initialize
+	string clusterPlacement = "least-loaded";  // or "memory" or "p2c"
+	string clockMode = "free";
+	string memoryBacking = "anonymous";  // or a file path to map the simulated memory from
+	bool memoryStamps = true;  // off for sweep runs, which would overwrite each other's files
 
 
 	// declare consoles 
 	std::shared_ptr<BaseScreen> currentConsole;
 	std::stringstream logStream;
-	std::unordered_map<string, std::shared_ptr<BaseScreen>> screenMap;
+	std::unordered_map<int, std::shared_ptr<BaseScreen>> screenMap;  // keyed by pid
+	std::mutex screenMapMutex;
+	int processCounter = 0;  // suffix of the last generated "P<n>" process
+	std::mutex batchMutex;
+	std::atomic<bool> replayRunning{ false };
+	std::atomic<int> replaySubmitted{ 0 };
+	std::atomic<int> replayDuplicates{ 0 };
+	shared_ptr<WorkloadTrace> replay;  // last trace replayed, kept for its status
+	string replayPath;
+	std::thread replayThread;
 
 	Scheduler scheduler;
 };
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "Dashboard.h"
+#include "Cluster.h"
+#include "Colors.h"
+#include "ConsoleManager.h"
+#include "EmulatorContext.h"
+#include "ProcessNameTable.h"
+#include "ProcessTable.h"
+#include "Scheduler.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// alternate screen with a hidden cursor while the view is up
+#define ENTER_VIEW "\033[?1049h\033[?25l"
+#define LEAVE_VIEW "\033[?25h\033[?1049l"
+#define REVERSE    "\033[7m"
+
+Dashboard::Dashboard(int rows, std::chrono::milliseconds refresh)
+	: rows(std::max(1, rows)), refresh(std::max(refresh, std::chrono::milliseconds(50)))
+{
+}
+
+void Dashboard::addLine(vector<Line>& frame, const string& text, const string& style)
+{
+	string padded = text.substr(0, WIDTH);
+	padded.resize(WIDTH, ' ');
+	frame.push_back({ padded, style });
+}
+
+vector<Dashboard::Line> Dashboard::buildFrame()
+{
+	// Counters and the first pids of each state only; nothing here waits on a core
+	ConsoleManager* consoleManager = ConsoleManager::getInstance();
+	Cluster* cluster = Cluster::getInstance();
+	ProcessTable* table = ProcessTable::getInstance();
+	int coresUsed = cluster->getCoresUsed();
+	int coresTotal = coresUsed + cluster->getCoresAvailable();
+	int running = table->getCountInState(ProcessTable::RUNNING);
+	int ready = table->getCountInState(ProcessTable::READY);
+	int waiting = table->getCountInState(ProcessTable::WAITING);
+	int finished = table->getCountInState(ProcessTable::FINISHED);
+
+	vector<Line> frame;
+	char text[160];
+	snprintf(text, sizeof(text), "top - %s   CPU cycles: %llu   scheduler: %s   nodes: %d",
+		consoleManager->getCurrentTimestamp().c_str(), static_cast<unsigned long long>(Scheduler::getInstance()->getCpuCycles()),
+		consoleManager->getSchedulerConfig().c_str(), cluster->getNumNodes());
+	addLine(frame, text);
+	snprintf(text, sizeof(text), "Cores: %d used, %d available (%.1f%% utilization)",
+		coresUsed, coresTotal - coresUsed, coresTotal == 0 ? 0.0 : 100.0 * coresUsed / coresTotal);
+	addLine(frame, text);
+	snprintf(text, sizeof(text), "Processes: %d total, %d running, %d ready, %d waiting, %d finished",
+		running + ready + waiting + finished, running, ready, waiting, finished);
+	addLine(frame, text);
+	addLine(frame, "");
+	addLine(frame, "    PID  NAME                  STATE     CORE      LINE / TOTAL   PROGRESS", REVERSE);
+
+	// Processes on a core first, then those queued, then those blocked
+	vector<int> pids = table->getPidsInState(ProcessTable::RUNNING, rows);
+	for (ProcessTable::State state : { ProcessTable::READY, ProcessTable::WAITING }) {
+		vector<int> more = table->getPidsInState(state, rows - pids.size());
+		pids.insert(pids.end(), more.begin(), more.end());
+	}
+	for (int pid : pids) {
+		ProcessTable::Snapshot snapshot = table->getSnapshot(pid);
+		const char* state = snapshot.state == ProcessTable::RUNNING ? "RUNNING" : snapshot.state == ProcessTable::WAITING ? "WAITING" : "READY";
+		string core = snapshot.state == ProcessTable::RUNNING && snapshot.coreId >= 0 ? to_string(snapshot.coreId) : "-";
+		double progress = snapshot.totalLine == 0 ? 0.0 : 100.0 * snapshot.currentLine / snapshot.totalLine;
+		snprintf(text, sizeof(text), "%7d  %-20.20s  %-8s  %4s  %8d / %-5d  %7.1f%%", pid,
+			ProcessNameTable::getInstance()->getName(pid).c_str(), state, core.c_str(), snapshot.currentLine, snapshot.totalLine, progress);
+		addLine(frame, text, snapshot.state == ProcessTable::RUNNING ? GREEN : snapshot.state == ProcessTable::WAITING ? YELLOW : "");
+	}
+	while (static_cast<int>(frame.size()) < 5 + rows) {
+		addLine(frame, "");
+	}
+	return frame;
+}
+
+string Dashboard::renderChanges(const vector<Line>& frame)
+{
+	// Rewrites each row from its first to its last changed column
+	string changes = previous.empty() ? "\033[2J" : "";
+	for (size_t row = 0; row < frame.size(); row++) {
+		const Line& line = frame[row];
+		size_t first = 0;
+		size_t last = WIDTH;
+		if (row < previous.size() && previous[row].style == line.style) {
+			const string& old = previous[row].text;
+			while (first < last && old[first] == line.text[first]) {
+				first++;
+			}
+			if (first == last) {
+				continue;
+			}
+			while (old[last - 1] == line.text[last - 1]) {
+				last--;
+			}
+		}
+		changes += "\033[" + to_string(row + 1) + ";" + to_string(first + 1) + "H";
+		changes += line.style;
+		changes.append(line.text, first, last - first);
+		if (!line.style.empty()) {
+			changes += RESET;
+		}
+	}
+	previous = frame;
+	return changes;
+}
+
+void Dashboard::run(istream& input)
+{
+#ifdef _WIN32
+	// Cursor movement needs virtual terminal processing on the Windows console
+	HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD mode = 0;
+	if (GetConsoleMode(console, &mode)) {
+		SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+	}
+#endif
+	cout << ENTER_VIEW << flush;
+	previous.clear();
+
+	std::mutex stopMutex;
+	std::condition_variable stopCondition;
+	bool stopping = false;
+	std::thread renderer = EmulatorContext::startThread([&] {
+		std::unique_lock<std::mutex> lock(stopMutex);
+		while (!stopping) {
+			lock.unlock();
+			vector<Line> frame = buildFrame();
+			addLine(frame, "");
+			addLine(frame, "Press Enter to return to the console.");
+			string changes = renderChanges(frame);
+			cout.write(changes.data(), changes.size());
+			cout.flush();
+			lock.lock();
+			stopCondition.wait_for(lock, refresh, [&] { return stopping; });
+		}
+		});
+
+	string line;
+	getline(input, line);
+	{
+		std::lock_guard<std::mutex> lock(stopMutex);
+		stopping = true;
+	}
+	stopCondition.notify_all();
+	renderer.join();
+	cout << LEAVE_VIEW << flush;
+}
+
+void Dashboard::printFrame(ostream& out)
+{
+	string text;
+	for (const Line& line : buildFrame()) {
+		size_t end = line.text.find_last_not_of(' ');
+		text.append(line.text, 0, end == string::npos ? 0 : end + 1);
+		text += '\n';
+	}
+	out << text << flush;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Live top-style view of the emulator for the top command. A render thread
+// takes a snapshot of the clock, the cores and the process table at a fixed
+// rate and builds a frame of fixed-width rows. Only the cells that changed
+// since the last frame are rewritten, using ANSI cursor positioning, and the
+// whole frame goes out in one write. Rows are filled from the process table's
+// state indexes, so a frame costs the same with thousands of processes as
+// with a handful, and the cores never wait on the view.
+class Dashboard
+{
+public:
+	Dashboard(int rows, std::chrono::milliseconds refresh);
+
+	// Refreshes until a line is read from input, on the terminal's alternate screen
+	void run(istream& input);
+	// Prints a single plain frame, for batch mode
+	void printFrame(ostream& out);
+
+	static constexpr int WIDTH = 96;
+
+private:
+	struct Line
+	{
+		string text;  // padded to WIDTH
+		string style;  // ANSI prefix, empty for plain text
+	};
+
+	vector<Line> buildFrame();
+	string renderChanges(const vector<Line>& frame);
+	void addLine(vector<Line>& frame, const string& text, const string& style = "");
+
+	int rows;  // process rows below the summary
+	std::chrono::milliseconds refresh;
+	vector<Line> previous;  // last frame drawn, empty before the first
+};
@@ -0,0 +1,70 @@
+#include "EmulatorContext.h"
+#include "Cluster.h"
+#include "ConsoleManager.h"
+#include "IMemoryAllocator.h"
+#include "InputManager.h"
+#include "ProcessNameTable.h"
+#include "ProcessTable.h"
+#include "Scheduler.h"
+#include "TraceRecorder.h"
+
+// context of the calling thread; nullptr until it binds one
+thread_local EmulatorContext* boundContext = nullptr;
+
+EmulatorContext* EmulatorContext::current()
+{
+	if (boundContext != nullptr) {
+		return boundContext;
+	}
+	// Never freed, like the singletons it replaces: detached threads may still use it at exit
+	static EmulatorContext* defaultContext = new EmulatorContext();
+	return defaultContext;
+}
+
+std::thread EmulatorContext::startThread(std::function<void()> body)
+{
+	EmulatorContext* context = current();
+	return std::thread([context, body]() {
+		Binding binding(context);
+		body();
+		});
+}
+
+EmulatorContext::Binding::Binding(EmulatorContext* context)
+	: previous(boundContext)
+{
+	boundContext = context;
+}
+
+EmulatorContext::Binding::~Binding()
+{
+	boundContext = previous;
+}
+
+EmulatorContext::EmulatorContext()
+	: processNameTable(new ProcessNameTable()), processTable(new ProcessTable()), traceRecorder(new TraceRecorder())
+{
+}
+
+EmulatorContext::~EmulatorContext()
+{
+	// Components reach each other through getInstance() while shutting down
+	Binding binding(this);
+
+	// A replay places processes on the cluster, so it has to end before the cluster goes
+	if (consoleManager != nullptr) {
+		consoleManager->stopReplay();
+	}
+	delete inputManager;
+	// Joins every node's cores and the balancer before anything they use is freed
+	delete cluster;
+	if (scheduler != nullptr) {
+		scheduler->stop();
+	}
+	delete consoleManager;
+	delete scheduler;
+	delete memoryAllocator;
+	delete processTable;
+	delete processNameTable;
+	delete traceRecorder;
+}
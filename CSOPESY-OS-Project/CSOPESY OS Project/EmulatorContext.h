@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+class ConsoleManager;
+class InputManager;
+class Scheduler;
+class IMemoryAllocator;
+class Cluster;
+class ProcessNameTable;
+class ProcessTable;
+class TraceRecorder;
+
+// Everything one emulator instance owns: its config (the console manager),
+// node 0's scheduler and allocator, the cluster, the process tables, the
+// trace recorder and the workload seed. The getInstance() accessors resolve
+// through the context bound to the calling thread, so independent emulators
+// can run side by side in one process, e.g. for scheduler-sweep.
+//
+// A thread that never bound a context uses the default one, which is the
+// interactive emulator. Threads the emulator starts must be created with
+// startThread() so that they inherit their creator's context.
+class EmulatorContext
+{
+public:
+	// Creates the tables core threads reach first, so getInstance() never races to build them
+	EmulatorContext();
+	// Stops the cluster and frees every component the context created
+	~EmulatorContext();
+
+	EmulatorContext(const EmulatorContext&) = delete;
+	EmulatorContext& operator=(const EmulatorContext&) = delete;
+
+	static EmulatorContext* current();
+	static std::thread startThread(std::function<void()> body);
+
+	// Makes a context current on this thread until the binding goes out of scope
+	class Binding
+	{
+	public:
+		explicit Binding(EmulatorContext* context);
+		~Binding();
+
+	private:
+		EmulatorContext* previous;
+	};
+
+	ConsoleManager* consoleManager = nullptr;
+	InputManager* inputManager = nullptr;
+	Scheduler* scheduler = nullptr;
+	IMemoryAllocator* memoryAllocator = nullptr;
+	Cluster* cluster = nullptr;
+	ProcessNameTable* processNameTable = nullptr;
+	ProcessTable* processTable = nullptr;
+	TraceRecorder* traceRecorder = nullptr;
+	uint64_t workloadSeed = 1;
+};
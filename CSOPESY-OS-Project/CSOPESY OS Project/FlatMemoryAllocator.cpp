@@ -1,69 +1,236 @@
 using namespace std;
 
 #include "FlatMemoryAllocator.h"
-#include "ConsoleManager.h"
+#include "TraceRecorder.h"
 #include <algorithm>
-#include <fstream>
+#include <sstream>
 
 
-FlatMemoryAllocator::FlatMemoryAllocator(size_t maximumSize) : maximumSize(maximumSize), allocatedSize(0)
+FlatMemoryAllocator::FlatMemoryAllocator(size_t maximumSize, int numCores, size_t magazineSize, string backing)
+	: maximumSize(maximumSize), allocatedSize(0), memory(maximumSize, backing), magazineSize(magazineSize)
 {
-	memory.resize(maximumSize);
-
 	initializeMemory();
+
+	if (magazineSize > 0) {
+		for (int core = 0; core < numCores; ++core) {
+			magazines.push_back(std::make_unique<Magazine>());
+		}
+	}
 }
 
 FlatMemoryAllocator::~FlatMemoryAllocator()
 {
-	memory.clear();
 }
 
-FlatMemoryAllocator* FlatMemoryAllocator::flatMemoryAllocator = nullptr;
+std::unique_lock<std::mutex> FlatMemoryAllocator::lockAllocationMap() {
+	// Count how often a thread finds the shared lock already held
+	std::unique_lock<std::mutex> lock(allocationMapMutex, std::try_to_lock);
+	if (!lock.owns_lock()) {
+		globalLockContentions++;
+		lock.lock();
+	}
+	globalLockAcquisitions++;
+	return lock;
+}
+
+size_t FlatMemoryAllocator::findFreeBlock(size_t size) {
+	if (size == 0 || size > maximumSize) {
+		return maximumSize;
+	}
+
+	// First fit over the gaps between blocks, lowest address first
+	size_t gapStart = 0;
+	for (const auto& block : allocations) {
+		if (block.first - gapStart >= size) {
+			return gapStart;
+		}
+		gapStart = block.first + block.second.size;
+	}
+	return (maximumSize - gapStart >= size) ? gapStart : maximumSize;
+}
+
+void* FlatMemoryAllocator::allocateShared(size_t size, int pid) {
+	{
+		std::unique_lock<std::mutex> lock = lockAllocationMap();  // Lock to ensure thread safety
+
+		size_t index = findFreeBlock(size);
+		if (index < maximumSize && allocateAt(index, size, pid)) {
+			return &memory[index];  // Return pointer to allocated memory
+		}
+	}
 
-void FlatMemoryAllocator::initialize(size_t maximumMemorySize) {
-	flatMemoryAllocator = new FlatMemoryAllocator(maximumMemorySize);
+	return nullptr;  // Return nullptr if allocation fails
 }
 
-FlatMemoryAllocator* FlatMemoryAllocator::getInstance() {
-	return flatMemoryAllocator;
+void* FlatMemoryAllocator::allocate(size_t size, int pid) {
+	void* ptr = allocateShared(size, pid);
+	TraceRecorder::getInstance()->record(nodeId, -1, ptr ? TraceRecorder::ALLOC_OK : TraceRecorder::ALLOC_FAIL, pid, static_cast<int64_t>(size));
+	return ptr;
 }
 
-std::mutex allocationMapMutex;  // Mutex for protecting allocationMap
+void* FlatMemoryAllocator::allocate(size_t size, int pid, int core) {
+	if (magazineSize == 0 || core < 0 || core >= static_cast<int>(magazines.size())) {
+		void* ptr = allocateShared(size, pid);
+		TraceRecorder::getInstance()->record(nodeId, core, ptr ? TraceRecorder::ALLOC_OK : TraceRecorder::ALLOC_FAIL, pid, static_cast<int64_t>(size));
+		return ptr;
+	}
 
-void* FlatMemoryAllocator::allocate(size_t size, string process) {
-	{
-		std::lock_guard<std::mutex> lock(allocationMapMutex);  // Lock to ensure thread safety
-
-		// Check for the availability of a suitable block
-		for (size_t i = 0; i < maximumSize - size + 1; ++i) {
-			// Check if the memory block is available
-			if (allocationMap.find(i) == allocationMap.end() || allocationMap[i].empty()) {
-				if (canAllocateAt(i, size)) {
-					// Ensure that the requested block doesn't go out of bounds
-					if (i + size <= maximumSize) {
-						allocateAt(i, size, process);
-						return &memory[i];  // Return pointer to allocated memory
-					}
+	Magazine& magazine = *magazines[core];
+	std::lock_guard<std::mutex> magazineLock(magazine.mutex);
+	std::vector<size_t>& blocks = magazine.freeBlocks[size];
+	if (blocks.empty()) {
+		magazine.misses++;
+		refillMagazine(magazine, core, size);
+
+		if (blocks.empty()) {
+			// Memory is exhausted: give back blocks of other sizes cached on this core and retry once
+			for (auto& cached : magazine.freeBlocks) {
+				if (cached.first != size) {
+					drainMagazine(magazine, cached.first, 0);
 				}
 			}
+			refillMagazine(magazine, core, size);
 		}
+		if (blocks.empty()) {
+			TraceRecorder::getInstance()->record(nodeId, core, TraceRecorder::ALLOC_FAIL, pid, static_cast<int64_t>(size));
+			return nullptr;
+		}
+	}
+	else {
+		magazine.hits++;
 	}
 
-	return nullptr;  // Return nullptr if allocation fails
+	size_t index = blocks.back();
+	blocks.pop_back();
+	magazine.owners[index] = { pid, size };
+	TraceRecorder::getInstance()->record(nodeId, core, TraceRecorder::ALLOC_OK, pid, static_cast<int64_t>(size));
+	return &memory[index];
+}
+
+void FlatMemoryAllocator::refillMagazine(Magazine& magazine, int core, size_t size) {
+	std::unique_lock<std::mutex> lock = lockAllocationMap();
+	std::vector<size_t>& blocks = magazine.freeBlocks[size];
+
+	// Cached blocks are tagged with the core so the shared map never hands them out twice
+	int tag = MAGAZINE_TAG - core;
+	for (size_t i = 0; i < magazineSize; ++i) {
+		size_t index = findFreeBlock(size);
+		if (index >= maximumSize || !allocateAt(index, size, tag)) {
+			break;
+		}
+		blocks.push_back(index);
+	}
+	magazineRefills++;
 }
 
+void FlatMemoryAllocator::drainMagazine(Magazine& magazine, size_t size, size_t keep) {
+	std::vector<size_t>& blocks = magazine.freeBlocks[size];
+	if (blocks.size() <= keep) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock = lockAllocationMap();
+	while (blocks.size() > keep) {
+		deallocateAt(blocks.back());
+		blocks.pop_back();
+	}
+	magazineDrains++;
+}
 
+int FlatMemoryAllocator::releaseShared(size_t index) {
+	std::unique_lock<std::mutex> lock = lockAllocationMap();
+	auto block = allocations.find(index);
+	if (block == allocations.end()) {
+		return FREE;
+	}
+	int pid = block->second.pid;
+	deallocateAt(index);
+	return pid;
+}
 
 void FlatMemoryAllocator::deallocate(void* ptr) {
-	std::lock_guard<std::mutex> lock(allocationMapMutex);
-	size_t index = static_cast<char*>(ptr) - &memory[0];
-	if (allocationMap[index] != "") {
-		deallocateAt(index);
+	int pid = releaseShared(static_cast<char*>(ptr) - memory.data());
+	TraceRecorder::getInstance()->record(nodeId, -1, TraceRecorder::FREE, pid);
+}
+
+void FlatMemoryAllocator::deallocate(void* ptr, int core) {
+	size_t index = static_cast<char*>(ptr) - memory.data();
+
+	// Usually the block came from this core's magazine; check the others before the shared map
+	for (size_t offset = 0; offset < magazines.size(); ++offset) {
+		size_t core_index = (static_cast<size_t>(core < 0 ? 0 : core) + offset) % magazines.size();
+		Magazine& magazine = *magazines[core_index];
+		std::lock_guard<std::mutex> magazineLock(magazine.mutex);
+
+		auto owner = magazine.owners.find(index);
+		if (owner != magazine.owners.end()) {
+			size_t size = owner->second.size;
+			TraceRecorder::getInstance()->record(nodeId, core, TraceRecorder::FREE, owner->second.pid);
+			magazine.owners.erase(owner);
+			magazine.freeBlocks[size].push_back(index);
+
+			// Keep at most two batches cached; hand the surplus back in one locked pass
+			if (magazine.freeBlocks[size].size() > 2 * magazineSize) {
+				drainMagazine(magazine, size, magazineSize);
+			}
+			return;
+		}
 	}
+
+	int pid = releaseShared(index);
+	TraceRecorder::getInstance()->record(nodeId, core, TraceRecorder::FREE, pid);
 }
 
-std::string FlatMemoryAllocator::visualizeMemory() {
-	return std::string(memory.begin(), memory.end());
+std::unordered_map<size_t, int> FlatMemoryAllocator::collectMagazineOwners() {
+	// Maps every magazine-held block to its process; cached but unused blocks map to FREE
+	std::unordered_map<size_t, int> magazineOwners;
+	for (auto& magazine : magazines) {
+		std::lock_guard<std::mutex> magazineLock(magazine->mutex);
+		for (const auto& cached : magazine->freeBlocks) {
+			for (size_t index : cached.second) {
+				magazineOwners[index] = FREE;
+			}
+		}
+		for (const auto& owner : magazine->owners) {
+			magazineOwners[owner.first] = owner.second.pid;
+		}
+	}
+	return magazineOwners;
+}
+
+std::string FlatMemoryAllocator::getAllocatorStats() {
+	std::ostringstream stats;
+	size_t acquisitions = globalLockAcquisitions.load();
+	size_t contentions = globalLockContentions.load();
+	stats << "Shared allocation map lock acquisitions: " << acquisitions << "\n";
+	stats << "Contended acquisitions: " << contentions;
+	if (acquisitions > 0) {
+		stats << " (" << (100.0 * contentions / acquisitions) << "%)";
+	}
+	stats << "\n";
+	stats << "Simulated memory: " << memory.describe() << "\n";
+
+	if (magazines.empty()) {
+		stats << "Per-core magazines: disabled (magazine-size 0)\n";
+		return stats.str();
+	}
+
+	stats << "Per-core magazines: " << magazineSize << " blocks per refill, "
+		<< magazineRefills.load() << " refills, " << magazineDrains.load() << " drains\n";
+	for (size_t core = 0; core < magazines.size(); ++core) {
+		std::lock_guard<std::mutex> magazineLock(magazines[core]->mutex);
+		size_t cached = 0;
+		for (const auto& blocks : magazines[core]->freeBlocks) {
+			cached += blocks.second.size();
+		}
+		stats << "  Core " << core << ": " << magazines[core]->hits << " hits, " << magazines[core]->misses
+			<< " misses, " << cached << " cached, " << magazines[core]->owners.size() << " in use\n";
+	}
+	return stats.str();
+}
+
+std::string_view FlatMemoryAllocator::viewMemory(size_t offset, size_t count) {
+	return memory.view(offset, count);
 }
 
 void FlatMemoryAllocator::visualizeMemoryASCII() {
@@ -75,89 +242,101 @@ void FlatMemoryAllocator::visualizeMemoryASCII() {
 
 
 void FlatMemoryAllocator::initializeMemory() {
-	// Initialize the memory vector with '.'
-	memory.resize(maximumSize, '.');
-
-	// Initialize the allocationMap with 'false' for all indices
-	for (size_t i = 0; i < maximumSize; ++i) {
-		allocationMap[i] = "";
-	}
+	// The mapping is populated lazily by the OS; only the block index needs resetting
+	allocations.clear();
+	allocatedSize = 0;
 }
 
 
 
 bool FlatMemoryAllocator::canAllocateAt(size_t index, size_t size) {
-	return (index + size <= maximumSize);
-}
+	if (size > maximumSize || index > maximumSize - size) {
+		return false;
+	}
 
-void FlatMemoryAllocator::allocateAt(size_t index, size_t size, string process) {
-	// Fill allocation map with true values starting from index until the process size
-	for (size_t i = index; i < index + size; ++i) {
-		allocationMap[i] = process;
+	// The range must end before the next block starts and begin after the previous one ends
+	auto next = allocations.lower_bound(index);
+	if (next != allocations.end() && next->first < index + size) {
+		return false;
 	}
-	allocatedSize += size;
+	if (next != allocations.begin()) {
+		auto previous = std::prev(next);
+		if (previous->first + previous->second.size > index) {
+			return false;
+		}
+	}
+	return true;
 }
 
-void FlatMemoryAllocator::deallocateAt(size_t index) {
-	size_t size = ConsoleManager::getInstance()->getMemPerProc();
-	for (size_t i = index; i < index + size && i < maximumSize; ++i) {
-		allocationMap[i] = "";
+bool FlatMemoryAllocator::allocateAt(size_t index, size_t size, int pid) {
+	// The simulated memory is only reserved until a block is carved from it
+	if (!memory.commit(index, size)) {
+		return false;
 	}
-	allocatedSize -= size;
+	allocations[index] = { size, pid };
+	allocatedSize += size;
+	return true;
 }
 
-void FlatMemoryAllocator::printMemoryInfo(int quantum_size) {
-	static int curr_quantum_cycle = 0;  // Counter for unique file naming
-	curr_quantum_cycle = curr_quantum_cycle + quantum_size;
-
-	// Create a unique filename for each call
-	std::string filename = "memory_stamp_" + std::to_string(curr_quantum_cycle) + ".txt";
-	std::ofstream outFile(filename);  // Open a uniquely named file for writing
-
-	if (!outFile) {  // Check if the file was successfully opened
-		std::cerr << "Error opening file for writing.\n";
+void FlatMemoryAllocator::deallocateAt(size_t index) {
+	auto it = allocations.find(index);
+	if (it == allocations.end()) {
 		return;
 	}
 
-	string timestamp = ConsoleManager::getInstance()->getCurrentTimestamp();
-	size_t numProcessesInMemory = FlatMemoryAllocator::getInstance()->getNumberOfProcessesInMemory();
-
-	// Print the information to the file
-	outFile << "Timestamp: " << timestamp << "\n";
-	outFile << "Number of processes in memory: " << numProcessesInMemory << "\n";
-	outFile << "Total External fragmentation in KB: " << calculateExternalFragmentation() << "\n\n";
-	outFile << "----end---- = " << maximumSize << "\n\n";
+	allocatedSize -= it->second.size;
+	allocations.erase(it);
+}
 
-	std::string currentProcessName = "";
-	std::string incomingProcessName = "";
+std::vector<IMemoryAllocator::MemoryRun> FlatMemoryAllocator::getMemoryMap() {
+	std::unordered_map<size_t, int> magazineOwners = collectMagazineOwners();
+	std::unique_lock<std::mutex> lock = lockAllocationMap();
 
-	for (size_t i = maximumSize - 1; i > 0; i--) {
-		incomingProcessName = allocationMap[i];
-		if (currentProcessName.empty() && !incomingProcessName.empty()) {
-			currentProcessName = incomingProcessName;
-			outFile << i + 1 << "\n" << currentProcessName << "\n";
+	// Blocks and the gaps between them, in address order; neighbouring free runs are merged
+	std::vector<MemoryRun> runs;
+	auto append = [&runs](size_t start, size_t end, int pid) {
+		if (start == end) {
+			return;
 		}
-		else if (currentProcessName != incomingProcessName) {
-			outFile << i + 1 << "\n";
-			currentProcessName = incomingProcessName;
-			outFile << currentProcessName << "\n";
+		if (pid == FREE && !runs.empty() && runs.back().pid == FREE && runs.back().end == start) {
+			runs.back().end = end;
 		}
-		else if (incomingProcessName.empty() && i == maximumSize - 1) {
-			outFile << i + 1 << "\n";
+		else {
+			runs.push_back({ start, end, pid });
 		}
-	}
-	outFile << "----start---- = 0\n";
+	};
+
+	size_t gapStart = 0;
+	for (const auto& block : allocations) {
+		append(gapStart, block.first, FREE);
 
-	outFile.close();  // Close the file
+		// A magazine block belongs to the process using it, or is free while it sits in the cache
+		int owner = block.second.pid;
+		if (owner <= MAGAZINE_TAG) {
+			auto cached = magazineOwners.find(block.first);
+			owner = (cached != magazineOwners.end()) ? cached->second : FREE;
+		}
+		append(block.first, block.first + block.second.size, owner);
+		gapStart = block.first + block.second.size;
+	}
+	append(gapStart, maximumSize, FREE);
+	return runs;
 }
 
 
 
 size_t FlatMemoryAllocator::calculateExternalFragmentation() {
-	size_t externalFragmentation = 0;
-	for (size_t i = 0; i < maximumSize; i += 1) {
-		if (allocationMap[i] == "") {
-			externalFragmentation++;
+	std::unordered_map<size_t, int> magazineOwners = collectMagazineOwners();
+	std::unique_lock<std::mutex> lock = lockAllocationMap();
+	size_t externalFragmentation = maximumSize - allocatedSize;
+
+	// Blocks cached in a magazine but not handed to a process are free as far as processes are concerned
+	for (const auto& cached : magazineOwners) {
+		if (cached.second == FREE) {
+			auto block = allocations.find(cached.first);
+			if (block != allocations.end()) {
+				externalFragmentation += block->second.size;
+			}
 		}
 	}
 	return externalFragmentation;
@@ -165,19 +344,15 @@ size_t FlatMemoryAllocator::calculateExternalFragmentation() {
 
 
 size_t FlatMemoryAllocator::getNumberOfProcessesInMemory() {
-	size_t allocatedBlocks = 0;
-
-	{
-		std::lock_guard<std::mutex> lock(allocationMapMutex);
-
-		// Iterate through the allocation map and count allocated blocks
-		for (size_t i = 0; i < allocationMap.size(); ++i) {
-			if (allocationMap.find(i) != allocationMap.end() && !allocationMap[i].empty()) {  // If the block is allocated
-				allocatedBlocks++;
-			}
+	size_t cachedBlocks = 0;
+	for (const auto& cached : collectMagazineOwners()) {
+		if (cached.second == FREE) {
+			cachedBlocks++;
 		}
 	}
-	// Calculate the number of processes
-	size_t processSizeInBlocks = ConsoleManager::getInstance()->getMemPerProc();  // Number of blocks per process
-	return allocatedBlocks / processSizeInBlocks;  // Total number of processes in memory
+
+	std::unique_lock<std::mutex> lock = lockAllocationMap();
+
+	// Each live allocation belongs to exactly one process, except blocks idling in a magazine
+	return (allocations.size() > cachedBlocks) ? allocations.size() - cachedBlocks : 0;
 }
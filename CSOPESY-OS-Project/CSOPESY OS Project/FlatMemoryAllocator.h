@@ -2,37 +2,87 @@
 #include <iostream>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "IMemoryAllocator.h"
+#include "SimulatedMemory.h"
 
 using namespace std;
 
-class FlatMemoryAllocator
+class FlatMemoryAllocator : public IMemoryAllocator
 {
 public:
 	~FlatMemoryAllocator();
 
-	FlatMemoryAllocator(size_t maximumSize);
-	void* allocate(size_t size, string process);
-	void deallocate(void* ptr);
-	std::string visualizeMemory();
+	FlatMemoryAllocator(size_t maximumSize, int numCores = 0, size_t magazineSize = 0, string backing = "anonymous");
+	void* allocate(size_t size, int pid) override;
+	void deallocate(void* ptr) override;
+	void* allocate(size_t size, int pid, int core) override;
+	void deallocate(void* ptr, int core) override;
+	std::string getAllocatorStats() override;
+	std::string_view viewMemory(size_t offset, size_t count) override;
 	void visualizeMemoryASCII();
 	void initializeMemory();
 	bool canAllocateAt(size_t index, size_t size);
-	void allocateAt(size_t index, size_t size, string processName);
+	bool allocateAt(size_t index, size_t size, int pid);  // false if the memory could not be committed
 	void deallocateAt(size_t index);
-	static FlatMemoryAllocator* getInstance();
-	static void initialize(size_t maximumMemorySize);
-	FlatMemoryAllocator() : maximumSize(0), allocatedSize(0) {};
+	FlatMemoryAllocator() : maximumSize(0), allocatedSize(0), memory(0) {};
 
-	void printMemoryInfo(int quantum);
-	size_t calculateExternalFragmentation();
-	size_t getNumberOfProcessesInMemory();
+	vector<MemoryRun> getMemoryMap() override;
+	size_t calculateExternalFragmentation() override;
+	size_t getNumberOfProcessesInMemory() override;
 
 private:
-	static FlatMemoryAllocator* flatMemoryAllocator;
+	// Per-core cache of pre-carved blocks, grouped by block size. Blocks are carved from and
+	// returned to the shared allocation map in batches, so the common allocate/deallocate on a
+	// core only takes that core's own (normally uncontended) mutex.
+	struct Magazine
+	{
+		struct BlockOwner
+		{
+			int pid;
+			size_t size;
+		};
+
+		std::mutex mutex;
+		std::unordered_map<size_t, std::vector<size_t>> freeBlocks;  // block size -> cached start indices
+		std::unordered_map<size_t, BlockOwner> owners;  // start index -> process using the block
+		size_t hits = 0;
+		size_t misses = 0;
+	};
+
+	size_t findFreeBlock(size_t size);
+	void* allocateShared(size_t size, int pid);
+	int releaseShared(size_t index);
+	std::unique_lock<std::mutex> lockAllocationMap();
+	void refillMagazine(Magazine& magazine, int core, size_t size);
+	void drainMagazine(Magazine& magazine, size_t size, size_t keep);
+	std::unordered_map<size_t, int> collectMagazineOwners();
+
+	static const int FREE = -1;
+	static const int MAGAZINE_TAG = -2;  // cached blocks of core N are tagged MAGAZINE_TAG - N
+
+	// One live block; blocks never overlap, so the gaps between them are the free memory
+	struct Allocation
+	{
+		size_t size;
+		int pid;  // owning process, or a MAGAZINE_TAG value for blocks cached on a core
+	};
+
 	size_t maximumSize;
 	size_t allocatedSize;
-	std::vector<char> memory;
-	std::unordered_map<size_t, string> allocationMap;
+	SimulatedMemory memory;
+	std::map<size_t, Allocation> allocations;  // block index: start index -> block
+	std::mutex allocationMapMutex;  // guards the block index; one per allocator, so cluster nodes never share it
+
+	std::vector<std::unique_ptr<Magazine>> magazines;
+	size_t magazineSize = 0;  // blocks carved per refill; 0 disables the per-core caches
+	std::atomic<size_t> globalLockAcquisitions{ 0 };
+	std::atomic<size_t> globalLockContentions{ 0 };
+	std::atomic<size_t> magazineRefills{ 0 };
+	std::atomic<size_t> magazineDrains{ 0 };
 
 
 };
@@ -0,0 +1,77 @@
+#include "HostAffinity.h"
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+vector<int> HostAffinity::parseMapping(string value)
+{
+	vector<int> mapping;
+	int hostCpus = getHostCpuCount();
+
+	if (value.empty() || value == "off") {
+		return mapping;
+	}
+
+	if (value == "auto") {
+		for (int cpu = 0; cpu < hostCpus; cpu++) {
+			mapping.push_back(cpu);
+		}
+		return mapping;
+	}
+
+	stringstream stream(value);
+	string entry;
+	while (getline(stream, entry, ',')) {
+		try {
+			int cpu = stoi(entry);
+			if (cpu >= 0 && cpu < hostCpus) {
+				mapping.push_back(cpu);
+			}
+		}
+		catch (...) {
+			// skip entries that are not numbers
+		}
+	}
+	return mapping;
+}
+
+bool HostAffinity::pinCurrentThread(int hostCpu)
+{
+	if (hostCpu < 0 || hostCpu >= getHostCpuCount()) {
+		return false;
+	}
+
+#ifdef _WIN32
+	if (hostCpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+		return false;  // beyond the default processor group
+	}
+	return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << hostCpu) != 0;
+#else
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(hostCpu, &cpuSet);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#endif
+}
+
+int HostAffinity::getCurrentHostCpu()
+{
+#ifdef _WIN32
+	return static_cast<int>(GetCurrentProcessorNumber());
+#else
+	return sched_getcpu();
+#endif
+}
+
+int HostAffinity::getHostCpuCount()
+{
+	unsigned int count = std::thread::hardware_concurrency();
+	return count == 0 ? 1 : static_cast<int>(count);
+}
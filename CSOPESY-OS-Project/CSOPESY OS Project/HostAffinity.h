@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Pins simulated core threads to host CPUs so benchmark runs are not skewed by
+// the OS moving them around. Uses SetThreadAffinityMask on Windows and
+// pthread_setaffinity_np elsewhere.
+class HostAffinity
+{
+public:
+	// Parses the core-pinning config value: "off" (or empty) disables pinning,
+	// "auto" maps simulated core i to host CPU i modulo the host CPU count, and
+	// a comma separated list such as "0,2,4,6" maps core i to entry i modulo its length
+	static vector<int> parseMapping(string value);
+
+	static bool pinCurrentThread(int hostCpu);
+	static int getCurrentHostCpu();  // -1 when the platform cannot tell
+	static int getHostCpuCount();
+};
@@ -15,3 +15,8 @@ void ICommand::execute()
 {
 	// Do nothing
 }
+
+int ICommand::getBlockingTicks() const
+{
+	return 0;
+}
@@ -5,12 +5,14 @@ public:
 	enum CommandType
 	{
 		IO,
-		PRINT
+		PRINT,
+		SLEEP
 	};
 
 	ICommand(int pid, CommandType commandType);
 	CommandType getCommandType();
 	virtual void execute();
+	virtual int getBlockingTicks() const;  // ticks the process waits off-core after this command
 
 protected:
 	int pid;
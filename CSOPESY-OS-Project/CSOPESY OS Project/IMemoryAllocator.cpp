@@ -0,0 +1,78 @@
+#include "IMemoryAllocator.h"
+#include "FlatMemoryAllocator.h"
+#include "BitmapMemoryAllocator.h"
+#include "ConsoleManager.h"
+#include "ProcessNameTable.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "EmulatorContext.h"
+
+IMemoryAllocator* IMemoryAllocator::create(size_t maximumMemorySize, size_t memPerFrame, string backend, int numCores, size_t magazineSize, string backing)
+{
+	if (backend == "bitmap") {
+		return new BitmapMemoryAllocator(maximumMemorySize, memPerFrame, backing);
+	}
+	return new FlatMemoryAllocator(maximumMemorySize, numCores, magazineSize, backing);
+}
+
+void IMemoryAllocator::initialize(size_t maximumMemorySize, size_t memPerFrame, string backend, int numCores, size_t magazineSize, string backing)
+{
+	// the active backend lives in the emulator context of the calling thread. Re-initializing
+	// replaces it; the cores that used it must be stopped, and they free their memory at the end of every burst
+	IMemoryAllocator*& memoryAllocator = EmulatorContext::current()->memoryAllocator;
+	delete memoryAllocator;
+	memoryAllocator = create(maximumMemorySize, memPerFrame, backend, numCores, magazineSize, backing);
+}
+
+IMemoryAllocator* IMemoryAllocator::getInstance()
+{
+	return EmulatorContext::current()->memoryAllocator;
+}
+
+void IMemoryAllocator::printMemoryInfo(int quantum_size)
+{
+	int curr_quantum_cycle = stampCycle.fetch_add(quantum_size) + quantum_size;  // Counter for unique file naming
+
+	std::string filename = "memory_stamp_" + std::to_string(curr_quantum_cycle) + ".txt";
+	std::ofstream outFile(filename);
+
+	if (!outFile) {
+		std::cerr << "Error opening file for writing.\n";
+		return;
+	}
+
+	string timestamp = ConsoleManager::getInstance()->getCurrentTimestamp();
+	size_t numProcessesInMemory = this->getNumberOfProcessesInMemory();
+	vector<MemoryRun> runs = this->getMemoryMap();
+	size_t maximumSize = runs.empty() ? 0 : runs.back().end;
+
+	outFile << "Timestamp: " << timestamp << "\n";
+	outFile << "Number of processes in memory: " << numProcessesInMemory << "\n";
+	outFile << "Total External fragmentation in KB: " << calculateExternalFragmentation() << "\n\n";
+	outFile << "----end---- = " << maximumSize << "\n\n";
+
+	// Highest address first: upper bound, owner, lower bound of every allocated run
+	for (auto run = runs.rbegin(); run != runs.rend(); ++run) {
+		if (run->pid != FREE_RUN) {
+			outFile << run->end << "\n" << ProcessNameTable::getInstance()->getName(run->pid) << "\n" << run->start << "\n\n";
+		}
+	}
+	outFile << "----start---- = 0\n";
+
+	outFile.close();
+}
+
+void IMemoryAllocator::printMemoryMap(ostream& out)
+{
+	vector<MemoryRun> runs = this->getMemoryMap();
+	size_t maximumSize = runs.empty() ? 0 : runs.back().end;
+	int width = static_cast<int>(std::to_string(maximumSize).size());
+
+	out << "Memory map: " << maximumSize << " bytes in " << runs.size() << " runs" << "\n";
+	for (const MemoryRun& run : runs) {
+		out << "  " << std::setw(width) << run.start << " - " << std::setw(width) << run.end
+			<< "  " << std::setw(width) << (run.end - run.start) << " bytes  "
+			<< (run.pid == FREE_RUN ? "free" : ProcessNameTable::getInstance()->getName(run.pid)) << "\n";
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Common interface for the memory allocator backends. The active backend is
+// chosen by the "memory-allocator" config key when the emulator is initialized.
+class IMemoryAllocator
+{
+public:
+	// One run of the memory map: bytes [start, end) held by pid, or FREE_RUN for unallocated memory
+	struct MemoryRun
+	{
+		size_t start;
+		size_t end;
+		int pid;
+	};
+	static const int FREE_RUN = -1;
+
+	virtual ~IMemoryAllocator() = default;
+
+	virtual void* allocate(size_t size, int pid) = 0;
+	virtual void deallocate(void* ptr) = 0;
+
+	// Core-aware variants used by the scheduler; backends without per-core caching ignore the core
+	virtual void* allocate(size_t size, int pid, int core) { return allocate(size, pid); }
+	virtual void deallocate(void* ptr, int core) { deallocate(ptr); }
+	virtual std::string getAllocatorStats() { return ""; }
+	// Cluster node this memory belongs to, for the trace
+	void setNodeId(int nodeId) { this->nodeId = nodeId; }
+
+	// Contents of the simulated physical memory, viewed in place rather than copied
+	virtual std::string_view viewMemory(size_t offset, size_t count) { return std::string_view(); }
+	// Run-length map covering [0, maximum size) in address order, built from the allocation
+	// list so its cost depends on the number of allocations rather than the memory size
+	virtual vector<MemoryRun> getMemoryMap() = 0;
+	virtual void printMemoryInfo(int quantum);  // writes the next memory_stamp_<n>.txt
+	void printMemoryMap(ostream& out);  // compact view for memory --map
+	virtual size_t calculateExternalFragmentation() = 0;
+	virtual size_t getNumberOfProcessesInMemory() = 0;
+
+	static IMemoryAllocator* getInstance();
+	// Builds a backend without making it the shared instance, e.g. for another cluster node
+	static IMemoryAllocator* create(size_t maximumMemorySize, size_t memPerFrame, string backend, int numCores, size_t magazineSize, string backing);
+	static void initialize(size_t maximumMemorySize, size_t memPerFrame, string backend, int numCores, size_t magazineSize, string backing);
+
+protected:
+	int nodeId = 0;
+	std::atomic<int> stampCycle{ 0 };  // cycles covered by the stamps written so far, names the next file
+};
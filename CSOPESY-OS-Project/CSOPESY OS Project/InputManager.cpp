@@ -1,46 +1,97 @@
 using namespace std;
 
 #include "InputManager.h"
+#include <chrono>
+#include <climits>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
+#include <thread>
 #include "ConsoleManager.h"
-#include "FlatMemoryAllocator.h"
+#include "IMemoryAllocator.h"
+#include "BitmapMemoryAllocator.h"
+#include "TraceRecorder.h"
+#include "Checkpoint.h"
+#include "Cluster.h"
+#include "WorkloadRandom.h"
 #include "Screen.h"
 #include "Colors.h"
+#include "EmulatorContext.h"
+#include "ParameterSweep.h"
+#include "Dashboard.h"
 
 InputManager::InputManager()
 {
+    this->registerCommands();
 }
 
-// stores the created instance of console manager
-InputManager* InputManager::inputManager = inputManager;
-
-
+// the instance lives in the emulator context of the calling thread
 void InputManager::initialize()
 {
-    inputManager = new InputManager();
+    EmulatorContext::current()->inputManager = new InputManager();
 }
 
 void InputManager::destroy()
 {
-    delete inputManager;
+    EmulatorContext* context = EmulatorContext::current();
+    delete context->inputManager;
+    context->inputManager = nullptr;
 }
 
 InputManager* InputManager::getInstance()
 {
-    return inputManager;
+    return EmulatorContext::current()->inputManager;
+}
+
+void InputManager::registerCommands()
+{
+    // Main console commands
+    mainCommands["initialize"] = &InputManager::initializeCommand;
+    mainCommands["exit"] = &InputManager::exitCommand;
+    mainCommands["scheduler-start"] = &InputManager::schedulerStartCommand;
+    mainCommands["scheduler-stop"] = &InputManager::schedulerStopCommand;
+    mainCommands["scheduler-replay"] = &InputManager::schedulerReplayCommand;
+    mainCommands["scheduler-sweep"] = &InputManager::schedulerSweepCommand;
+    mainCommands["report-util"] = &InputManager::reportUtilCommand;
+    mainCommands["scheduler-stats"] = &InputManager::schedulerStatsCommand;
+    mainCommands["top"] = &InputManager::topCommand;
+    mainCommands["clear"] = &InputManager::clearCommand;
+    mainCommands["help"] = &InputManager::helpCommand;
+    mainCommands["memory"] = &InputManager::memoryCommand;
+    mainCommands["memory-stats"] = &InputManager::memoryStatsCommand;
+    mainCommands["memory-view"] = &InputManager::memoryViewCommand;
+    mainCommands["memory-bench"] = &InputManager::memoryBenchCommand;
+    mainCommands["trace-start"] = &InputManager::traceStartCommand;
+    mainCommands["trace-stop"] = &InputManager::traceStopCommand;
+    mainCommands["trace-export"] = &InputManager::traceExportCommand;
+    mainCommands["checkpoint"] = &InputManager::checkpointCommand;
+    mainCommands["restore"] = &InputManager::checkpointCommand;
+    mainCommands["cores"] = &InputManager::coresCommand;
+    mainCommands["nodes"] = &InputManager::nodesCommand;
+    mainCommands["screen"] = &InputManager::screenCommand;
+    mainCommands["script"] = &InputManager::scriptCommand;
+
+    // Process-specific commands
+    processCommands["exit"] = &InputManager::exitProcessCommand;
+    processCommands["process-smi"] = &InputManager::processSmiCommand;
 }
 
 void InputManager::handleMainConsoleInput()
 {
     cout << "root:\\> ";
     string input;
-    getline(cin, input); // Capture entire line input
-
-    // Convert input to lowercase
-    for (char& c : input) {
-        c = tolower(c);
+    if (!getline(cin, input)) {
+        // End of piped input behaves like exit instead of prompting forever
+        cout << endl;
+        this->executeCommand("exit");
+        return;
     }
+    this->executeCommand(input);
+}
 
+void InputManager::executeCommand(string input)
+{
     // Split input by spaces
     istringstream iss(input);
     vector<string> tokens{ istream_iterator<string>{iss}, istream_iterator<string>{} };
@@ -50,6 +101,10 @@ void InputManager::handleMainConsoleInput()
         return;
     }
 
+    // Only the command name is case-insensitive; arguments such as file paths and process names keep their case
+    for (char& c : tokens[0]) {
+        c = tolower(static_cast<unsigned char>(c));
+    }
     string command = tokens[0];
 
     // Check initialization state once
@@ -58,139 +113,528 @@ void InputManager::handleMainConsoleInput()
         return;
     }
 
-    // Main Console commands
-    if (ConsoleManager::getInstance()->getCurrentConsole()->getConsoleName() == MAIN_CONSOLE) {
-        if (command == "initialize") {
-            ConsoleManager::getInstance()->setInitialized(true);
-            ConsoleManager::getInstance()->initializeConfiguration();
+    bool mainConsole = ConsoleManager::getInstance()->getCurrentConsole()->getConsoleName() == MAIN_CONSOLE;
+    const unordered_map<string, CommandHandler>& commands = mainConsole ? mainCommands : processCommands;
+    auto handler = commands.find(command);
+    if (handler == commands.end()) {
+        cout << RED << "> Error! Unrecognized command : " << command << RESET << endl;
+        return;
+    }
+    (this->*handler->second)(tokens);
+}
 
-            // Start scheduler
-            Scheduler::getInstance()->initialize(ConsoleManager::getInstance()->getNumCpu());
-            std::thread schedulerThread([&] {
-                Scheduler::getInstance()->start();
-                });
-            schedulerThread.detach();
+int InputManager::runScript(istream& script)
+{
+    // Batch mode: no screen clearing or console redraws between commands
+    ConsoleManager* consoleManager = ConsoleManager::getInstance();
+    bool wasBatchMode = consoleManager->isBatchMode();
+    consoleManager->setBatchMode(true);
 
-            cout << GREEN << "> Processor Configuration Initialized" << RESET << endl;
+    int executed = 0;
+    string line;
+    while (consoleManager->isRunning() && getline(script, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#') {
+            continue;
         }
-        else if (command == "exit") {
-            cout << RED << "> Exiting emulator..." << RESET << endl;
-            ConsoleManager::getInstance()->exitApplication();
+        this->executeCommand(line);
+        executed++;
+    }
+
+    consoleManager->setBatchMode(wasBatchMode);
+    return executed;
+}
+
+void InputManager::initializeCommand(const vector<string>& tokens)
+{
+    ConsoleManager::getInstance()->setInitialized(true);
+    ConsoleManager::getInstance()->initializeConfiguration();
+
+    // Seed the workload streams before any process is generated
+    WorkloadRandom::setSeed(ConsoleManager::getInstance()->getSeed());
+
+    // Create the nodes, each with the memory allocator backend selected in config.txt and a scheduler
+    Cluster::initialize(ConsoleManager::getInstance()->getNumNodes());
+    Cluster::getInstance()->start();
+
+    cout << GREEN << "> Processor Configuration Initialized (workload seed " << WorkloadRandom::getSeed() << ")" << RESET << endl;
+}
+
+void InputManager::exitCommand(const vector<string>& tokens)
+{
+    cout << RED << "> Exiting emulator..." << RESET << endl;
+    ConsoleManager::getInstance()->exitApplication();
+}
+
+void InputManager::schedulerStartCommand(const vector<string>& tokens)
+{
+    if (!Scheduler::getInstance()->getSchedulerTestRunning()) {
+        cout << GREEN << "> Scheduler now running" << RESET << endl;
+        cout << GREEN << "> Creating dummy processes..." << RESET << endl;
+        Scheduler::getInstance()->setSchedulerTestRunning(true);
+        // create batchProcessFrequency number of processes
+        std::thread schedulerTestThread = EmulatorContext::startThread([] {
+            ConsoleManager::getInstance()->schedulerTest();
+            });
+        schedulerTestThread.detach();
+
+    }
+    else {
+        cout << YELLOW << "> Scheduler Test already running" << RESET << endl;
+    }
+}
+
+void InputManager::schedulerStopCommand(const vector<string>& tokens)
+{
+    if (ConsoleManager::getInstance()->isReplayRunning()) {
+        cout << GREEN << "> Stopping trace replay..." << RESET << endl;
+        ConsoleManager::getInstance()->stopReplay();
+        if (!Scheduler::getInstance()->getSchedulerTestRunning()) {
+            return;
         }
-        else if (command == "scheduler-start") {
-            if (!Scheduler::getInstance()->getSchedulerTestRunning()) {
-                cout << GREEN << "> Scheduler now running" << RESET << endl;
-                cout << GREEN << "> Creating dummy processes..." << RESET << endl;
-                Scheduler::getInstance()->setSchedulerTestRunning(true);
-                // create batchProcessFrequency number of processes
-                std::thread schedulerTestThread([&] {
-                    ConsoleManager::getInstance()->schedulerTest();
-                    });
-                schedulerTestThread.detach();
+    }
+    if (Scheduler::getInstance()->getSchedulerTestRunning()) {
+        cout << RED << "> Scheduler stopped" << RESET << endl;
+        cout << GREEN << "> Stopping creation of dummy processes..." << RESET << endl;
+        Scheduler::getInstance()->setSchedulerTestRunning(false);
+    }
+    else {
+        cout << RED << "> Scheduler not running" << RESET << endl;
+    }
+}
+
+void InputManager::schedulerReplayCommand(const vector<string>& tokens)
+{
+    // scheduler-replay <file> [scale]; without a file, shows the progress of the last replay
+    if (tokens.size() < 2) {
+        ConsoleManager::getInstance()->printReplayStatus(cout);
+        return;
+    }
 
+    uint64_t scale = 1;
+    try {
+        scale = (tokens.size() > 2) ? stoull(tokens[2]) : 1;
+    }
+    catch (...) {
+        scale = 0;
+    }
+    if (scale == 0) {
+        cout << RED << "> Usage: scheduler-replay <file.swf|file.csv> [scale]" << RESET << endl;
+        return;
+    }
+
+    string error;
+    if (ConsoleManager::getInstance()->startReplay(tokens[1], scale, error)) {
+        cout << GREEN << "> Replaying jobs from " << tokens[1] << RESET << endl;
+    }
+    else {
+        cout << RED << "> Error: " << error << RESET << endl;
+    }
+}
+
+void InputManager::schedulerSweepCommand(const vector<string>& tokens)
+{
+    // scheduler-sweep <quanta> <cpu counts> [ticks] [parallel], with comma-separated lists
+    auto parseList = [](const string& list, int low, int high) {
+        vector<int> values;
+        stringstream stream(list);
+        string item;
+        while (getline(stream, item, ',')) {
+            int value = 0;
+            try {
+                value = stoi(item);
             }
-            else {
-                cout << YELLOW << "> Scheduler Test already running" << RESET << endl;
+            catch (...) {
+                return vector<int>();
             }
+            if (value < low || value > high) {
+                return vector<int>();
+            }
+            values.push_back(value);
+        }
+        return values;
+    };
+
+    vector<int> quanta = tokens.size() > 2 ? parseList(tokens[1], 1, INT_MAX) : vector<int>();
+    vector<int> cpuCounts = tokens.size() > 2 ? parseList(tokens[2], 1, 128) : vector<int>();
+    uint64_t ticks = 0;
+    int parallel = 0;
+    try {
+        ticks = tokens.size() > 3 ? stoull(tokens[3]) : 200;
+        parallel = tokens.size() > 4 ? stoi(tokens[4]) : static_cast<int>(std::thread::hardware_concurrency());
+    }
+    catch (...) {
+        ticks = 0;
+    }
+    if (quanta.empty() || cpuCounts.empty() || ticks == 0) {
+        cout << RED << "> Usage: scheduler-sweep <quantum,...> <num-cpu,...> [ticks] [parallel]" << RESET << endl;
+        return;
+    }
+
+    // Every run generates this emulator's workload, so only the swept parameters differ
+    uint64_t seed = WorkloadRandom::getSeed();
+    parallel = std::max(1, parallel);
+
+    cout << GREEN << "> Sweeping " << quanta.size() * cpuCounts.size() << " configurations for " << ticks
+        << " ticks each, " << parallel << " at a time (workload seed " << seed << ")" << RESET << endl;
+    vector<ParameterSweep::Result> results = ParameterSweep::run(quanta, cpuCounts, ticks, seed, parallel);
+    ParameterSweep::printResults(results, cout);
+}
+
+void InputManager::topCommand(const vector<string>& tokens)
+{
+    // top [rows] [refresh-ms]: live view until Enter; batch mode prints one frame
+    int rows = 0;
+    int refreshMs = 0;
+    try {
+        rows = (tokens.size() > 1) ? stoi(tokens[1]) : 20;
+        refreshMs = (tokens.size() > 2) ? stoi(tokens[2]) : 500;
+    }
+    catch (...) {
+        rows = 0;
+    }
+    if (rows < 1 || refreshMs < 1) {
+        cout << RED << "> Usage: top [rows] [refresh-ms]" << RESET << endl;
+        return;
+    }
+
+    Dashboard dashboard(rows, std::chrono::milliseconds(refreshMs));
+    if (ConsoleManager::getInstance()->isBatchMode()) {
+        dashboard.printFrame(cout);
+    }
+    else {
+        dashboard.run(cin);
+    }
+}
+
+void InputManager::reportUtilCommand(const vector<string>& tokens)
+{
+    ConsoleManager::getInstance()->reportUtil();
+}
+
+void InputManager::schedulerStatsCommand(const vector<string>& tokens)
+{
+    ConsoleManager::getInstance()->printWaitStats(cout);
+    ConsoleManager::getInstance()->printAffinityStats(cout);
+}
+
+void InputManager::clearCommand(const vector<string>& tokens)
+{
+    ConsoleManager::getInstance()->clearScreen();
+    ConsoleManager::getInstance()->drawConsole();
+}
+
+void InputManager::helpCommand(const vector<string>& tokens)
+{
+    // Display the list of available commands
+    cout << LIGHT_YELLOW << "> List of commands:" << endl
+        << "    - initialize            (initializes processor configuration and scheduler based on config.txt)" << endl
+        << "    - screen -s <name> [p]  (start a new process, priority p from 0 (highest, default) to 7)" << endl
+        << "    - screen -r <name>      (reattaches to an existing process)" << endl
+        << "    - screen -ls            (list all processes; filters: --running, --finished, --core N," << endl
+        << "                             --sort pid|name|progress|remaining, --top N)" << endl
+        << "    - process-smi           (prints process info, only applicable when attached to a process)" << endl
+        << "    - scheduler-start        (starts the creation of dummy processes at configured intervals)" << endl
+        << "    - scheduler-stop        (stops scheduler-test process creation and any trace replay)" << endl
+        << "    - scheduler-replay <file> [scale] (creates the jobs of an SWF or CSV trace as they arrive;" << endl
+        << "                             scale divides arrival times and lengths, no file shows progress)" << endl
+        << "    - scheduler-sweep <quanta> <cpus> [ticks] [parallel] (runs scheduler-test for every" << endl
+        << "                             quantum-cycles/num-cpu pair in separate emulators, e.g. 1,2,4 1,2)" << endl
+        << "    - report-util           (generates a CPU utilization report and writes it to csopesy-log.txt)" << endl
+        << "    - top [rows] [refresh-ms] (live view of cores and processes, redrawn in place until Enter)" << endl
+        << "    - scheduler-stats       (shows ready-queue wait times by priority and core migrations)" << endl
+        << "    - trace-start           (starts recording per-core scheduling and memory events)" << endl
+        << "    - trace-stop            (stops recording events)" << endl
+        << "    - trace-export [file]   (writes recorded events as Chrome trace JSON, default text_files/trace.json)" << endl
+        << "    - cores [n]             (shows cores with host CPU placement, or resizes every node to n cores)" << endl
+        << "    - nodes                 (shows per-node utilization, memory and cross-node migrations)" << endl
+        << "    - checkpoint <file>     (saves processes, queues, clocks and memory configuration to a file)" << endl
+        << "    - restore <file>        (loads a checkpoint into a freshly initialized emulator)" << endl
+        << "    - memory [--map]        (writes a memory stamp of the current allocations, or prints the map)" << endl
+        << "    - memory-stats          (shows allocator lock contention and per-core magazine usage)" << endl
+        << "    - memory-view <offset> [count] (hex dump of simulated memory, read in place)" << endl
+        << "    - memory-bench          (measures bitmap allocator allocations/sec at 1 GB of memory)" << endl
+        << "    - script <file>         (runs the commands in a file without clearing or redrawing the screen)" << endl
+        << "    - clear                 (clears the screen)" << endl
+        << "    - help                  (displays list of commands)" << endl
+        << "    - exit                  (exits the emulator)" << RESET << endl;
+}
+
+void InputManager::memoryCommand(const vector<string>& tokens)
+{
+    if (tokens.size() > 1 && tokens[1] == "--map") {
+        IMemoryAllocator::getInstance()->printMemoryMap(cout);
+    }
+    else {
+        IMemoryAllocator::getInstance()->printMemoryInfo(ConsoleManager::getInstance()->getTimeSlice());
+    }
+}
+
+void InputManager::memoryStatsCommand(const vector<string>& tokens)
+{
+    string stats = IMemoryAllocator::getInstance()->getAllocatorStats();
+    cout << (stats.empty() ? "No allocator statistics for this backend.\n" : stats);
+}
+
+void InputManager::memoryViewCommand(const vector<string>& tokens)
+{
+    // Hex dump of a window of simulated memory, read in place from the mapping
+    size_t offset = 0;
+    size_t count = 256;
+    try {
+        offset = (tokens.size() > 1) ? stoull(tokens[1]) : 0;
+        count = (tokens.size() > 2) ? stoull(tokens[2]) : 256;
+    }
+    catch (...) {
+        count = 0;
+    }
+
+    string_view bytes = IMemoryAllocator::getInstance()->viewMemory(offset, std::min<size_t>(count, 4096));
+    if (bytes.empty()) {
+        cout << RED << "> Usage: memory-view <offset> [count] (offset must be inside the simulated memory)" << RESET << endl;
+    }
+    for (size_t row = 0; row < bytes.size(); row += 16) {
+        char line[128];
+        int written = snprintf(line, sizeof(line), "%010zu ", offset + row);
+        string ascii;
+        for (size_t i = row; i < row + 16 && i < bytes.size(); i++) {
+            unsigned char byte = static_cast<unsigned char>(bytes[i]);
+            written += snprintf(line + written, sizeof(line) - written, " %02x", byte);
+            ascii += isprint(byte) ? static_cast<char>(byte) : '.';
+        }
+        cout << line << "  " << ascii << endl;
+    }
+}
+
+void InputManager::memoryBenchCommand(const vector<string>& tokens)
+{
+    // Bitmap allocator throughput at 1 GB of simulated memory
+    size_t minSize = ConsoleManager::getInstance()->getMinMemPerProc();
+    size_t maxSize = ConsoleManager::getInstance()->getMaxMemPerProc();
+    if (minSize == 0 || maxSize < minSize) {
+        minSize = maxSize = ConsoleManager::getInstance()->getMemPerProc();
+    }
+    BitmapMemoryAllocator::runBenchmark(size_t(1) << 30, ConsoleManager::getInstance()->getMemPerFrame(), minSize, maxSize);
+}
+
+void InputManager::traceStartCommand(const vector<string>& tokens)
+{
+    TraceRecorder::getInstance()->clear();
+    TraceRecorder::getInstance()->setEnabled(true);
+    cout << GREEN << "> Recording scheduler and memory events" << RESET << endl;
+}
+
+void InputManager::traceStopCommand(const vector<string>& tokens)
+{
+    TraceRecorder::getInstance()->setEnabled(false);
+    cout << GREEN << "> Stopped recording events" << RESET << endl;
+}
+
+void InputManager::traceExportCommand(const vector<string>& tokens)
+{
+    string path = (tokens.size() > 1) ? tokens[1] : "text_files/trace.json";
+    if (TraceRecorder::getInstance()->exportChromeTrace(path)) {
+        cout << "Trace written to " << path << " (open it in ui.perfetto.dev or chrome://tracing)" << endl;
+    }
+    else {
+        cerr << "Error: Could not open " << path << " for writing." << endl;
+    }
+}
+
+void InputManager::checkpointCommand(const vector<string>& tokens)
+{
+    if (tokens.size() < 2) {
+        cout << RED << "> Usage: " << tokens[0] << " <file>" << RESET << endl;
+    }
+    else {
+        string error;
+        auto started = std::chrono::steady_clock::now();
+        bool saved = (tokens[0] == "checkpoint") ? Checkpoint::save(tokens[1], error) : Checkpoint::restore(tokens[1], error);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        if (saved) {
+            cout << GREEN << "> " << (tokens[0] == "checkpoint" ? "Checkpoint written to " : "Restored from ")
+                << tokens[1] << " in " << elapsed.count() << " ms" << RESET << endl;
+        }
+        else {
+            cout << RED << "> Error: " << error << RESET << endl;
+        }
+    }
+}
+
+void InputManager::coresCommand(const vector<string>& tokens)
+{
+    // Grow or shrink the simulated CPU while the scheduler runs
+    if (tokens.size() > 1) {
+        int requested = 0;
+        try {
+            requested = stoi(tokens[1]);
+        }
+        catch (...) {
+            requested = 0;
+        }
+
+        if (requested < 1 || requested > 128) {
+            cout << RED << "> Error: core count must be between 1 and 128." << RESET << endl;
         }
-        else if (command == "scheduler-stop") {
-            if (Scheduler::getInstance()->getSchedulerTestRunning()) {
-                cout << RED << "> Scheduler stopped" << RESET << endl;
-                cout << GREEN << "> Stopping creation of dummy processes..." << RESET << endl;
-                Scheduler::getInstance()->setSchedulerTestRunning(false);
+        else {
+            int previous = Scheduler::getInstance()->getNumCores();
+            if (Cluster::getInstance()->setNumCores(requested)) {
+                ConsoleManager::getInstance()->setNumCpu(requested);
+                cout << GREEN << "> Cores changed from " << previous << " to " << requested << RESET << endl;
             }
             else {
-                cout << RED << "> Scheduler not running" << RESET << endl;
+                cout << RED << "> Error: cores cannot be resized in lockstep clock mode." << RESET << endl;
             }
         }
-        else if (command == "report-util") {
-            ConsoleManager::getInstance()->reportUtil();
-        }
-        else if (command == "clear") {
-            system("cls");
-            ConsoleManager::getInstance()->drawConsole();
+    }
+    else {
+        Scheduler* scheduler = Scheduler::getInstance();
+        cout << "Cores: " << scheduler->getNumCores()
+            << " (" << scheduler->getCoresUsed() << " used)" << endl;
+        for (int core = 0; core < scheduler->getNumCores(); core++) {
+            int pinned = scheduler->getPinnedHostCpu(core);
+            cout << "  Core " << core << ": host CPU " << scheduler->getLastHostCpu(core)
+                << (pinned == -1 ? " (unpinned)" : " (pinned to " + to_string(pinned) + ")")
+                << ", " << scheduler->getHostMigrations(core) << " migrations" << endl;
         }
-        else if (command == "help") {
-            // Display the list of available commands
-            cout << LIGHT_YELLOW << "> List of commands:" << endl
-                << "    - initialize            (initializes processor configuration and scheduler based on config.txt)" << endl
-                << "    - screen -s <name>      (start a new process)" << endl
-                << "    - screen -r <name>      (reattaches to an existing process)" << endl
-                << "    - screen -ls            (list all processes)" << endl
-                << "    - process-smi           (prints process info, only applicable when attached to a process)" << endl
-                << "    - scheduler-start        (starts the creation of dummy processes at configured intervals)" << endl
-                << "    - scheduler-stop        (stops the creation of dummy processes initiated by scheduler-test)" << endl
-                << "    - report-util           (generates a CPU utilization report and writes it to csopesy-log.txt)" << endl
-                << "    - clear                 (clears the screen)" << endl
-                << "    - help                  (displays list of commands)" << endl
-                << "    - exit                  (exits the emulator)" << RESET << endl;
+    }
+}
+
+void InputManager::nodesCommand(const vector<string>& tokens)
+{
+    Cluster::getInstance()->printNodes(cout);
+}
+
+void InputManager::screenCommand(const vector<string>& tokens)
+{
+    if (tokens.size() > 1) {
+        string screenCommand = tokens[1];
+        string processName = (tokens.size() > 2) ? tokens[2] : "";
+
+        if (screenCommand == "-s" && !processName.empty()) {
+            // Optional priority, 0 (highest, the default) to 7
+            int priority = Screen::HIGHEST_PRIORITY;
+            try {
+                priority = (tokens.size() > 3) ? stoi(tokens[3]) : Screen::HIGHEST_PRIORITY;
+            }
+            catch (...) {
+                priority = -1;
+            }
+
+            if (priority < Screen::HIGHEST_PRIORITY || priority > Screen::LOWEST_PRIORITY) {
+                cout << RED << "> Usage: screen -s <name> [priority 0-7]" << RESET << endl;
+            }
+            else if (ConsoleManager::getInstance()->findScreen(processName)) {
+                cout << RED << "> Error: Process already exists." << RESET << endl;
+            }
+            else {
+                string timestamp = ConsoleManager::getInstance()->getCurrentTimestamp();
+                auto screenInstance = std::make_shared<Screen>(processName, 0, timestamp, ConsoleManager::getInstance()->getRandomMemPerProc(processName));
+                screenInstance->setPriority(priority);
+                ConsoleManager::getInstance()->registerConsole(screenInstance);
+
+                ConsoleManager::getInstance()->switchConsole(processName);
+                ConsoleManager::getInstance()->drawConsole();
+                Cluster::getInstance()->place(screenInstance);
+            }
         }
-        else if (command == "memory") {
-            FlatMemoryAllocator::getInstance()->printMemoryInfo(ConsoleManager::getInstance()->getTimeSlice());
+        else if (screenCommand == "-r" && !processName.empty()) {
+            // Check if screen exists before switching
+            if (ConsoleManager::getInstance()->findScreen(processName)) {
+                ConsoleManager::getInstance()->switchConsole(processName);
+                ConsoleManager::getInstance()->drawConsole();
+            }
+            else {
+                cout << RED << "> Error: Screen with name '" << processName << "' does not exist or was not initialized." << RESET << endl;
+            }
         }
-        else if (command == "screen") {
-            if (tokens.size() > 1) {
-                string screenCommand = tokens[1];
-                string processName = (tokens.size() > 2) ? tokens[2] : "";
-
-                if (screenCommand == "-s" && !processName.empty()) {
-                    if (ConsoleManager::getInstance()->getScreenMap().contains(processName)) {
-                        cout << RED << "> Error: Process already exists." << RESET << endl;
+        else if (screenCommand == "-ls") {
+            // screen -ls [--running | --finished] [--core N] [--sort pid|name|progress|remaining] [--top N]
+            ProcessListOptions options;
+            bool valid = true;
+            for (size_t i = 2; i < tokens.size() && valid; i++) {
+                const string& option = tokens[i];
+                bool hasValue = i + 1 < tokens.size();
+                try {
+                    if (option == "--running") {
+                        options.showFinished = false;
                     }
-                    else {
-                        string timestamp = ConsoleManager::getInstance()->getCurrentTimestamp();
-                        auto screenInstance = std::make_shared<Screen>(processName, 0, timestamp, ConsoleManager::getInstance()->getMemPerProc());
-                        ConsoleManager::getInstance()->registerConsole(screenInstance);
-
-                        ConsoleManager::getInstance()->switchConsole(processName);
-                        ConsoleManager::getInstance()->drawConsole();
-                        Scheduler::getInstance()->addProcessToQueue(screenInstance);
+                    else if (option == "--finished") {
+                        options.showRunning = false;
                     }
-                }
-                else if (screenCommand == "-r" && !processName.empty()) {
-                    // Check if screen exists before switching
-                    auto screenMap = ConsoleManager::getInstance()->getScreenMap();
-                    if (screenMap.find(processName) != screenMap.end()) {
-                        ConsoleManager::getInstance()->switchConsole(processName);
-                        ConsoleManager::getInstance()->drawConsole();
+                    else if (option == "--core" && hasValue) {
+                        options.coreId = stoi(tokens[++i]);
+                    }
+                    else if (option == "--sort" && hasValue) {
+                        options.sortKey = tokens[++i];
+                        valid = options.sortKey == "pid" || options.sortKey == "name"
+                            || options.sortKey == "progress" || options.sortKey == "remaining";
+                    }
+                    else if (option == "--top" && hasValue) {
+                        options.top = stoi(tokens[++i]);
                     }
                     else {
-                        cout << RED << "> Error: Screen with name '" << processName << "' does not exist or was not initialized." << RESET << endl;
+                        valid = false;
                     }
                 }
-                else if (screenCommand == "-ls") {
-                    system("cls");
-                    ConsoleManager::getInstance()->drawConsole();
-                    cout << "root:\\> screen -ls" << endl;
-                    ConsoleManager::getInstance()->displayProcessList();
-                }
-                else {
-                    cout << RED << "> Error! Unrecognized command : " << command << RESET << endl;
+                catch (...) {
+                    valid = false;
                 }
             }
+
+            if (!valid || options.coreId < -1 || options.top < -1 || (!options.showRunning && !options.showFinished)) {
+                cout << RED << "> Usage: screen -ls [--running | --finished] [--core N] [--sort pid|name|progress|remaining] [--top N]" << RESET << endl;
+            }
             else {
-                cout << RED << "> Error! Unrecognized command : " << command << RESET << endl;
+                if (!ConsoleManager::getInstance()->isBatchMode()) {
+                    ConsoleManager::getInstance()->clearScreen();
+                    ConsoleManager::getInstance()->drawConsole();
+                    cout << "root:\\> " << tokens[0];
+                    for (size_t i = 1; i < tokens.size(); i++) {
+                        cout << " " << tokens[i];
+                    }
+                    cout << endl;
+                }
+                ConsoleManager::getInstance()->displayProcessList(options);
             }
         }
         else {
-            cout << RED << "> Error! Unrecognized command : " << command << RESET << endl;
+            cout << RED << "> Error! Unrecognized command : " << tokens[0] << RESET << endl;
         }
     }
     else {
-        // Process-specific commands
-        if (command == "exit") {
-            cout << "> Exiting process..." << endl;
-            ConsoleManager::getInstance()->switchConsole(MAIN_CONSOLE);
-        }
-        else if (command == "process-smi") {
-            string processName = ConsoleManager::getInstance()->getCurrentConsole()->getConsoleName();
-            ConsoleManager::getInstance()->printProcessSmi();
-            ConsoleManager::getInstance()->printProcess(processName);
-        }
-        else {
-            cout << RED << "> Error! Unrecognized command : " << command << RESET << endl;
-        }
+        cout << RED << "> Error! Unrecognized command : " << tokens[0] << RESET << endl;
     }
 }
 
+void InputManager::scriptCommand(const vector<string>& tokens)
+{
+    if (tokens.size() < 2) {
+        cout << RED << "> Usage: script <file>" << RESET << endl;
+        return;
+    }
+
+    ifstream script(tokens[1]);
+    if (!script) {
+        cout << RED << "> Error: Could not open " << tokens[1] << RESET << endl;
+        return;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    int executed = this->runScript(script);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    cout << GREEN << "> Ran " << executed << " commands from " << tokens[1] << " in " << elapsed.count() << " ms" << RESET << endl;
+}
 
+void InputManager::exitProcessCommand(const vector<string>& tokens)
+{
+    cout << "> Exiting process..." << endl;
+    ConsoleManager::getInstance()->switchConsole(MAIN_CONSOLE);
+}
+
+void InputManager::processSmiCommand(const vector<string>& tokens)
+{
+    string processName = ConsoleManager::getInstance()->getCurrentConsole()->getConsoleName();
+    ConsoleManager::getInstance()->printProcessSmi();
+    ConsoleManager::getInstance()->printProcess(processName);
+}
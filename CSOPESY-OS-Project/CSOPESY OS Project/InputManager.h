@@ -1,4 +1,9 @@
 #pragma once
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 class InputManager
 {
 public:
@@ -6,9 +11,43 @@ public:
 	static void initialize();
 	static InputManager* getInstance();
 	void handleMainConsoleInput();
+	// Runs one command line against the current console
+	void executeCommand(std::string input);
+	// Runs every line of a command script in batch mode; blank lines and # comments are skipped
+	int runScript(std::istream& script);
 	void destroy();
 
 private:
-	static InputManager* inputManager;
-};
+	typedef void (InputManager::*CommandHandler)(const std::vector<std::string>& tokens);
+
+	void registerCommands();
 
+	void initializeCommand(const std::vector<std::string>& tokens);
+	void exitCommand(const std::vector<std::string>& tokens);
+	void schedulerStartCommand(const std::vector<std::string>& tokens);
+	void schedulerStopCommand(const std::vector<std::string>& tokens);
+	void schedulerReplayCommand(const std::vector<std::string>& tokens);
+	void schedulerSweepCommand(const std::vector<std::string>& tokens);
+	void topCommand(const std::vector<std::string>& tokens);
+	void reportUtilCommand(const std::vector<std::string>& tokens);
+	void schedulerStatsCommand(const std::vector<std::string>& tokens);
+	void clearCommand(const std::vector<std::string>& tokens);
+	void helpCommand(const std::vector<std::string>& tokens);
+	void memoryCommand(const std::vector<std::string>& tokens);
+	void memoryStatsCommand(const std::vector<std::string>& tokens);
+	void memoryViewCommand(const std::vector<std::string>& tokens);
+	void memoryBenchCommand(const std::vector<std::string>& tokens);
+	void traceStartCommand(const std::vector<std::string>& tokens);
+	void traceStopCommand(const std::vector<std::string>& tokens);
+	void traceExportCommand(const std::vector<std::string>& tokens);
+	void checkpointCommand(const std::vector<std::string>& tokens);
+	void coresCommand(const std::vector<std::string>& tokens);
+	void nodesCommand(const std::vector<std::string>& tokens);
+	void screenCommand(const std::vector<std::string>& tokens);
+	void scriptCommand(const std::vector<std::string>& tokens);
+	void exitProcessCommand(const std::vector<std::string>& tokens);
+	void processSmiCommand(const std::vector<std::string>& tokens);
+
+	std::unordered_map<std::string, CommandHandler> mainCommands;  // commands of the main console
+	std::unordered_map<std::string, CommandHandler> processCommands;  // commands while attached to a process
+};
@@ -0,0 +1,119 @@
+#include "ParameterSweep.h"
+#include "Cluster.h"
+#include "ConsoleManager.h"
+#include "EmulatorContext.h"
+#include "ProcessTable.h"
+#include "Scheduler.h"
+#include "WorkloadRandom.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+vector<ParameterSweep::Result> ParameterSweep::run(const vector<int>& quanta, const vector<int>& cpuCounts, uint64_t ticks, uint64_t seed, int parallel)
+{
+	vector<Result> results(quanta.size() * cpuCounts.size());
+	std::atomic<size_t> nextRun{ 0 };
+
+	// Each runner takes the next combination until none are left
+	auto runner = [&]() {
+		for (size_t i = nextRun.fetch_add(1); i < results.size(); i = nextRun.fetch_add(1)) {
+			results[i] = runOne(quanta[i / cpuCounts.size()], cpuCounts[i % cpuCounts.size()], ticks, seed);
+		}
+	};
+	int runners = std::max(1, std::min(parallel, static_cast<int>(results.size())));
+	vector<std::thread> threads;
+	for (int i = 0; i < runners; i++) {
+		threads.emplace_back(runner);
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	return results;
+}
+
+ParameterSweep::Result ParameterSweep::runOne(int quantum, int numCpu, uint64_t ticks, uint64_t seed)
+{
+	Result result;
+	result.quantum = quantum;
+	result.numCpu = numCpu;
+	auto started = std::chrono::steady_clock::now();
+
+	EmulatorContext context;
+	{
+		EmulatorContext::Binding binding(&context);
+
+		// Same config and workload as every other run, except for the swept parameters.
+		// Runs leave host placement to the OS and keep their memory and stamps private
+		ConsoleManager::initialize();
+		ConsoleManager* consoleManager = ConsoleManager::getInstance();
+		consoleManager->initializeConfiguration();
+		consoleManager->setBatchMode(true);
+		consoleManager->setTimeSlice(quantum);
+		consoleManager->setNumCpu(numCpu);
+		consoleManager->setCorePinning("off");
+		consoleManager->setMemoryBacking("anonymous");
+		consoleManager->setMemoryStamps(false);
+		consoleManager->setSeed(seed);
+		consoleManager->setInitialized(true);
+		WorkloadRandom::setSeed(seed);
+		Cluster::initialize(consoleManager->getNumNodes());
+		Cluster* cluster = Cluster::getInstance();
+		cluster->start();
+
+		Scheduler* clock = Scheduler::getInstance();
+		clock->setSchedulerTestRunning(true);
+		std::thread generator = EmulatorContext::startThread([consoleManager] {
+			consoleManager->schedulerTest();
+			});
+
+		// Utilization is sampled once per tick, on node 0's clock
+		uint64_t busyCores = 0;
+		uint64_t totalCores = 0;
+		uint64_t end = clock->getCpuCycles() + ticks;
+		for (uint64_t tick = clock->getCpuCycles() + 1; tick <= end; tick = clock->getCpuCycles() + 1) {
+			if (clock->waitForTick(tick, std::chrono::milliseconds(100))) {
+				int used = cluster->getCoresUsed();
+				busyCores += used;
+				totalCores += used + cluster->getCoresAvailable();
+			}
+		}
+		clock->setSchedulerTestRunning(false);
+		generator.join();
+		cluster->stop();
+
+		result.ticks = ticks;
+		result.created = consoleManager->getProcessCounter();
+		result.finished = ProcessTable::getInstance()->getCountInState(ProcessTable::FINISHED);
+		result.utilization = totalCores == 0 ? 0.0 : 100.0 * busyCores / totalCores;
+		uint64_t totalWait = 0;
+		for (int node = 0; node < cluster->getNumNodes(); node++) {
+			Scheduler* scheduler = cluster->getScheduler(node);
+			for (int priority = Screen::HIGHEST_PRIORITY; priority <= Screen::LOWEST_PRIORITY; priority++) {
+				Scheduler::WaitStats stats = scheduler->getWaitStats(priority);
+				result.dispatches += stats.dispatches;
+				totalWait += stats.totalWait;
+				result.maxWait = std::max(result.maxWait, stats.maxWait);
+			}
+			result.migrations += scheduler->getAffinityStats().migrations;
+		}
+		result.averageWait = result.dispatches == 0 ? 0.0 : static_cast<double>(totalWait) / result.dispatches;
+	}
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	return result;
+}
+
+void ParameterSweep::printResults(const vector<Result>& results, ostream& out)
+{
+	out << "Quantum  CPUs   Ticks  Created  Finished  Util %  Dispatches  Avg wait  Max wait  Migrations  Seconds" << endl;
+	for (const Result& result : results) {
+		char row[160];
+		snprintf(row, sizeof(row), "%7d  %4d  %6llu  %7d  %8d  %6.1f  %10llu  %8.1f  %8llu  %10llu  %7.1f",
+			result.quantum, result.numCpu, static_cast<unsigned long long>(result.ticks), result.created, result.finished,
+			result.utilization, static_cast<unsigned long long>(result.dispatches), result.averageWait,
+			static_cast<unsigned long long>(result.maxWait), static_cast<unsigned long long>(result.migrations), result.seconds);
+		out << row << endl;
+	}
+}
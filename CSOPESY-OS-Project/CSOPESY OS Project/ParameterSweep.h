@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+// Runs the scheduler-test workload once for every quantum-cycles / num-cpu
+// combination, each in its own emulator context so the runs share nothing but
+// config.txt and the workload seed. Up to parallel runs execute at a time.
+// Every run generates processes for the given number of CPU ticks and reports
+// what it completed and how long processes waited to be dispatched.
+class ParameterSweep
+{
+public:
+	struct Result
+	{
+		int quantum = 0;
+		int numCpu = 0;
+		uint64_t ticks = 0;
+		int created = 0;
+		int finished = 0;
+		double utilization = 0.0;  // mean percentage of busy cores, sampled every tick
+		uint64_t dispatches = 0;
+		double averageWait = 0.0;  // ticks in the ready queue per dispatch
+		uint64_t maxWait = 0;
+		uint64_t migrations = 0;
+		double seconds = 0.0;
+	};
+
+	static vector<Result> run(const vector<int>& quanta, const vector<int>& cpuCounts, uint64_t ticks, uint64_t seed, int parallel);
+	static void printResults(const vector<Result>& results, ostream& out);
+
+private:
+	static Result runOne(int quantum, int numCpu, uint64_t ticks, uint64_t seed);
+};
@@ -0,0 +1,53 @@
+#include "ProcessNameTable.h"
+#include <mutex>
+#include "EmulatorContext.h"
+
+ProcessNameTable* ProcessNameTable::getInstance()
+{
+	// one per emulator context, created with it
+	return EmulatorContext::current()->processNameTable;
+}
+
+int ProcessNameTable::intern(const string& name)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(tableMutex);
+		auto it = pids.find(name);
+		if (it != pids.end()) {
+			return it->second;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(tableMutex);
+	auto it = pids.find(name);
+	if (it != pids.end()) {
+		return it->second;
+	}
+	int pid = static_cast<int>(names.size());
+	names.push_back(name);
+	pids.emplace(name, pid);
+	return pid;
+}
+
+int ProcessNameTable::findPid(const string& name)
+{
+	std::shared_lock<std::shared_mutex> lock(tableMutex);
+	auto it = pids.find(name);
+	return (it != pids.end()) ? it->second : NO_PID;
+}
+
+const string& ProcessNameTable::getName(int pid)
+{
+	static const string unknown = "";
+	std::shared_lock<std::shared_mutex> lock(tableMutex);
+	if (pid < 0 || pid >= static_cast<int>(names.size())) {
+		return unknown;
+	}
+	return names[pid];
+}
+
+int ProcessNameTable::size()
+{
+	std::shared_lock<std::shared_mutex> lock(tableMutex);
+	return static_cast<int>(names.size());
+}
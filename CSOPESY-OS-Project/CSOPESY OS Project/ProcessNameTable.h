@@ -0,0 +1,28 @@
+#pragma once
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// Interns process (console) names into compact integer PIDs. PIDs are handed
+// out densely from 0 in creation order and are used internally by the
+// scheduler, allocator and console; names are only looked up for display.
+class ProcessNameTable
+{
+public:
+	static const int NO_PID = -1;
+
+	static ProcessNameTable* getInstance();
+
+	int intern(const string& name);
+	int findPid(const string& name);
+	const string& getName(int pid);
+	int size();
+
+private:
+	std::shared_mutex tableMutex;
+	std::deque<string> names;  // pid -> name; deque keeps references stable as it grows
+	std::unordered_map<string, int> pids;
+};
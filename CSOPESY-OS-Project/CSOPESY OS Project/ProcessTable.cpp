@@ -0,0 +1,347 @@
+#include "ProcessTable.h"
+#include <algorithm>
+#include <thread>
+#include "EmulatorContext.h"
+
+ProcessTable::Chunk::Chunk()
+{
+	for (int i = 0; i < CHUNK_SIZE; i++) {
+		currentLine[i].store(0, std::memory_order_relaxed);
+		totalLine[i].store(0, std::memory_order_relaxed);
+		coreId[i].store(-1, std::memory_order_relaxed);
+		state[i].store(NOT_A_PROCESS, std::memory_order_relaxed);
+		finishedAt[i].store(0, std::memory_order_relaxed);
+		sequence[i].store(0, std::memory_order_relaxed);
+		indexedState[i] = NOT_A_PROCESS;
+		statePosition[i] = -1;
+		indexedCore[i] = -1;
+		corePosition[i] = -1;
+	}
+}
+
+void ProcessTable::beginWrite(Chunk* chunk, int slot)
+{
+	// Move the sequence from even to odd; spins only if another writer holds the entry
+	uint32_t sequence = chunk->sequence[slot].load(std::memory_order_relaxed);
+	while ((sequence & 1) || !chunk->sequence[slot].compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire)) {
+		sequence = chunk->sequence[slot].load(std::memory_order_relaxed);
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ProcessTable::endWrite(Chunk* chunk, int slot)
+{
+	chunk->sequence[slot].fetch_add(1, std::memory_order_release);
+}
+
+void ProcessTable::removeFromIndex(vector<int>& members, int position, bool stateIndex)
+{
+	// Swap-remove; the pid moved into the hole gets its position fixed up
+	int moved = members.back();
+	members[position] = moved;
+	members.pop_back();
+	if (position < static_cast<int>(members.size())) {
+		Chunk* movedChunk = chunkFor(moved);
+		int movedSlot = moved & (CHUNK_SIZE - 1);
+		if (stateIndex) {
+			movedChunk->statePosition[movedSlot] = position;
+		}
+		else {
+			movedChunk->corePosition[movedSlot] = position;
+		}
+	}
+}
+
+void ProcessTable::reindex(int pid, Chunk* chunk, int slot)
+{
+	// Called after a write; brings the state and core indexes in line with the entry
+	std::lock_guard<std::mutex> lock(indexMutex);
+	uint8_t state = chunk->state[slot].load(std::memory_order_relaxed);
+	int coreId = chunk->coreId[slot].load(std::memory_order_relaxed);
+	if (coreId >= MAX_INDEXED_CORES) {
+		coreId = -1;
+	}
+
+	if (chunk->indexedState[slot] != state) {
+		if (chunk->indexedState[slot] <= FINISHED) {
+			removeFromIndex(stateMembers[chunk->indexedState[slot]], chunk->statePosition[slot], true);
+		}
+		if (state <= FINISHED) {
+			chunk->statePosition[slot] = static_cast<int>(stateMembers[state].size());
+			stateMembers[state].push_back(pid);
+		}
+		chunk->indexedState[slot] = state;
+	}
+
+	if (chunk->indexedCore[slot] != coreId) {
+		if (chunk->indexedCore[slot] != -1) {
+			removeFromIndex(coreMembers[chunk->indexedCore[slot]], chunk->corePosition[slot], false);
+		}
+		if (coreId != -1) {
+			chunk->corePosition[slot] = static_cast<int>(coreMembers[coreId].size());
+			coreMembers[coreId].push_back(pid);
+		}
+		chunk->indexedCore[slot] = coreId;
+	}
+}
+
+vector<int> ProcessTable::copyInBatches(const vector<int>& members)
+{
+	// indexMutex is dropped between batches so a core publishing a dispatch or release waits
+	// for one batch at most. A pid that changes index meanwhile may be missed or seen twice,
+	// so, as with the separate per-state calls, the result is a moving view
+	vector<int> pids;
+	for (size_t position = 0;; position += INDEX_BATCH) {
+		std::lock_guard<std::mutex> lock(indexMutex);
+		if (position >= members.size()) {
+			return pids;
+		}
+		size_t end = std::min(members.size(), position + INDEX_BATCH);
+		pids.insert(pids.end(), members.begin() + position, members.begin() + end);
+	}
+}
+
+vector<int> ProcessTable::getPidsInState(State state)
+{
+	return (state <= FINISHED) ? copyInBatches(stateMembers[state]) : vector<int>();
+}
+
+vector<int> ProcessTable::getPidsInState(State state, size_t limit)
+{
+	std::lock_guard<std::mutex> lock(indexMutex);
+	if (state > FINISHED) {
+		return vector<int>();
+	}
+	const vector<int>& members = stateMembers[state];
+	return vector<int>(members.begin(), members.begin() + std::min(limit, members.size()));
+}
+
+int ProcessTable::getCountInState(State state)
+{
+	std::lock_guard<std::mutex> lock(indexMutex);
+	return (state <= FINISHED) ? static_cast<int>(stateMembers[state].size()) : 0;
+}
+
+vector<int> ProcessTable::getPidsOnCore(int coreId)
+{
+	return (coreId >= 0 && coreId < MAX_INDEXED_CORES) ? copyInBatches(coreMembers[coreId]) : vector<int>();
+}
+
+ProcessTable* ProcessTable::getInstance()
+{
+	// one per emulator context, created with it
+	return EmulatorContext::current()->processTable;
+}
+
+ProcessTable::~ProcessTable()
+{
+	for (std::atomic<Chunk*>& chunk : chunks) {
+		delete chunk.load();
+	}
+}
+
+ProcessTable::Chunk* ProcessTable::chunkFor(int pid) const
+{
+	if (pid < 0 || (pid >> CHUNK_BITS) >= MAX_CHUNKS) {
+		return nullptr;
+	}
+	return chunks[pid >> CHUNK_BITS].load(std::memory_order_acquire);
+}
+
+bool ProcessTable::addProcess(int pid)
+{
+	if (pid < 0 || (pid >> CHUNK_BITS) >= MAX_CHUNKS) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(growMutex);
+	Chunk* chunk = chunkFor(pid);
+	if (chunk == nullptr) {
+		chunk = new Chunk();
+		chunks[pid >> CHUNK_BITS].store(chunk, std::memory_order_release);
+	}
+
+	// A name that is reused while its process is still live interns to the same pid;
+	// resetting the entry would lose the live process's progress
+	int slot = pid & (CHUNK_SIZE - 1);
+	uint8_t state = chunk->state[slot].load(std::memory_order_relaxed);
+	if (state != NOT_A_PROCESS && state != FINISHED) {
+		return false;
+	}
+
+	beginWrite(chunk, slot);
+	chunk->currentLine[slot].store(0, std::memory_order_relaxed);
+	chunk->coreId[slot].store(-1, std::memory_order_relaxed);
+	chunk->finishedAt[slot].store(0, std::memory_order_relaxed);
+	chunk->state[slot].store(READY, std::memory_order_relaxed);
+	endWrite(chunk, slot);
+	reindex(pid, chunk, slot);
+
+	int limit = pidLimit.load(std::memory_order_relaxed);
+	while (limit <= pid && !pidLimit.compare_exchange_weak(limit, pid + 1)) {
+	}
+	return true;
+}
+
+int ProcessTable::size() const
+{
+	return pidLimit.load(std::memory_order_acquire);
+}
+
+bool ProcessTable::isProcess(int pid) const
+{
+	Chunk* chunk = chunkFor(pid);
+	return chunk && chunk->state[pid & (CHUNK_SIZE - 1)].load(std::memory_order_relaxed) != NOT_A_PROCESS;
+}
+
+int ProcessTable::getCurrentLine(int pid) const
+{
+	Chunk* chunk = chunkFor(pid);
+	return chunk ? chunk->currentLine[pid & (CHUNK_SIZE - 1)].load(std::memory_order_relaxed) : 0;
+}
+
+void ProcessTable::setCurrentLine(int pid, int currentLine)
+{
+	Chunk* chunk = chunkFor(pid);
+	if (chunk) {
+		int slot = pid & (CHUNK_SIZE - 1);
+		beginWrite(chunk, slot);
+		chunk->currentLine[slot].store(currentLine, std::memory_order_relaxed);
+		endWrite(chunk, slot);
+	}
+}
+
+int ProcessTable::getTotalLine(int pid) const
+{
+	Chunk* chunk = chunkFor(pid);
+	return chunk ? chunk->totalLine[pid & (CHUNK_SIZE - 1)].load(std::memory_order_relaxed) : 0;
+}
+
+void ProcessTable::setTotalLine(int pid, int totalLine)
+{
+	Chunk* chunk = chunkFor(pid);
+	if (chunk) {
+		int slot = pid & (CHUNK_SIZE - 1);
+		beginWrite(chunk, slot);
+		chunk->totalLine[slot].store(totalLine, std::memory_order_relaxed);
+		endWrite(chunk, slot);
+	}
+}
+
+int ProcessTable::getCoreId(int pid) const
+{
+	Chunk* chunk = chunkFor(pid);
+	return chunk ? chunk->coreId[pid & (CHUNK_SIZE - 1)].load(std::memory_order_relaxed) : -1;
+}
+
+void ProcessTable::setCoreId(int pid, int coreId)
+{
+	Chunk* chunk = chunkFor(pid);
+	if (chunk) {
+		int slot = pid & (CHUNK_SIZE - 1);
+		beginWrite(chunk, slot);
+		chunk->coreId[slot].store(coreId, std::memory_order_relaxed);
+		endWrite(chunk, slot);
+		reindex(pid, chunk, slot);
+	}
+}
+
+ProcessTable::State ProcessTable::getState(int pid) const
+{
+	Chunk* chunk = chunkFor(pid);
+	return chunk ? static_cast<State>(chunk->state[pid & (CHUNK_SIZE - 1)].load(std::memory_order_relaxed)) : NOT_A_PROCESS;
+}
+
+void ProcessTable::setState(int pid, State state)
+{
+	Chunk* chunk = chunkFor(pid);
+	if (chunk) {
+		int slot = pid & (CHUNK_SIZE - 1);
+		beginWrite(chunk, slot);
+		chunk->state[slot].store(state, std::memory_order_relaxed);
+		endWrite(chunk, slot);
+		reindex(pid, chunk, slot);
+	}
+}
+
+bool ProcessTable::isFinished(int pid) const
+{
+	Chunk* chunk = chunkFor(pid);
+	if (!chunk) {
+		return false;
+	}
+	int slot = pid & (CHUNK_SIZE - 1);
+	return chunk->currentLine[slot].load(std::memory_order_relaxed) >= chunk->totalLine[slot].load(std::memory_order_relaxed);
+}
+
+int64_t ProcessTable::getFinishedAt(int pid) const
+{
+	Chunk* chunk = chunkFor(pid);
+	return chunk ? chunk->finishedAt[pid & (CHUNK_SIZE - 1)].load(std::memory_order_relaxed) : 0;
+}
+
+void ProcessTable::setFinishedAt(int pid, int64_t finishedAt)
+{
+	Chunk* chunk = chunkFor(pid);
+	if (chunk) {
+		int slot = pid & (CHUNK_SIZE - 1);
+		beginWrite(chunk, slot);
+		chunk->finishedAt[slot].store(finishedAt, std::memory_order_relaxed);
+		endWrite(chunk, slot);
+	}
+}
+
+void ProcessTable::publishDispatch(int pid, int coreId)
+{
+	Chunk* chunk = chunkFor(pid);
+	if (chunk) {
+		int slot = pid & (CHUNK_SIZE - 1);
+		beginWrite(chunk, slot);
+		chunk->coreId[slot].store(coreId, std::memory_order_relaxed);
+		chunk->state[slot].store(RUNNING, std::memory_order_relaxed);
+		endWrite(chunk, slot);
+		reindex(pid, chunk, slot);
+	}
+}
+
+void ProcessTable::publishRelease(int pid, State state, int64_t finishedAt)
+{
+	Chunk* chunk = chunkFor(pid);
+	if (chunk) {
+		int slot = pid & (CHUNK_SIZE - 1);
+		beginWrite(chunk, slot);
+		chunk->state[slot].store(state, std::memory_order_relaxed);
+		chunk->finishedAt[slot].store(finishedAt, std::memory_order_relaxed);
+		endWrite(chunk, slot);
+		reindex(pid, chunk, slot);
+	}
+}
+
+ProcessTable::Snapshot ProcessTable::getSnapshot(int pid) const
+{
+	Snapshot snapshot = { pid, 0, 0, -1, NOT_A_PROCESS, 0 };
+	Chunk* chunk = chunkFor(pid);
+	if (!chunk) {
+		return snapshot;
+	}
+
+	int slot = pid & (CHUNK_SIZE - 1);
+	while (true) {
+		uint32_t before = chunk->sequence[slot].load(std::memory_order_acquire);
+		if (before & 1) {
+			std::this_thread::yield();  // a core thread is mid-update
+			continue;
+		}
+
+		snapshot.currentLine = chunk->currentLine[slot].load(std::memory_order_relaxed);
+		snapshot.totalLine = chunk->totalLine[slot].load(std::memory_order_relaxed);
+		snapshot.coreId = chunk->coreId[slot].load(std::memory_order_relaxed);
+		snapshot.state = static_cast<State>(chunk->state[slot].load(std::memory_order_relaxed));
+		snapshot.finishedAt = chunk->finishedAt[slot].load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (chunk->sequence[slot].load(std::memory_order_relaxed) == before) {
+			return snapshot;
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// Process control block table for the hot per-process fields. Fields are
+// stored as separate dense arrays indexed by pid (structure of arrays), so
+// scans such as screen -ls or utilization reports touch contiguous memory
+// instead of chasing one heap object per process. Storage grows in fixed
+// chunks that never move, so core threads and the UI can read and write
+// entries concurrently through relaxed atomics.
+//
+// Each entry also carries a sequence counter (seqlock): writers make it odd
+// while they update the entry and even again when done, and getSnapshot()
+// retries until it reads all fields under the same even value. The UI thus
+// gets a consistent view of a process without blocking the core threads.
+//
+// Secondary indexes keep the pids in each state and on each core as dense
+// sets, so filtered listings only touch the processes they print.
+class ProcessTable
+{
+public:
+	// Mirrors Screen::ProcessState; NOT_A_PROCESS marks pids that belong to plain consoles
+	enum State : uint8_t
+	{
+		READY,
+		RUNNING,
+		WAITING,
+		FINISHED,
+		NOT_A_PROCESS = 0xFF
+	};
+
+	// Consistent copy of one entry taken under the seqlock
+	struct Snapshot
+	{
+		int pid;
+		int currentLine;
+		int totalLine;
+		int coreId;
+		State state;
+		int64_t finishedAt;  // time_t of completion, 0 while unfinished
+	};
+
+	static ProcessTable* getInstance();
+	~ProcessTable();
+
+	// Starts a fresh READY entry; false if pid is still ready, running or waiting, which is left as it is
+	bool addProcess(int pid);
+	int size() const;
+	bool isProcess(int pid) const;
+
+	int getCurrentLine(int pid) const;
+	void setCurrentLine(int pid, int currentLine);
+	int getTotalLine(int pid) const;
+	void setTotalLine(int pid, int totalLine);
+	int getCoreId(int pid) const;
+	void setCoreId(int pid, int coreId);
+	State getState(int pid) const;
+	void setState(int pid, State state);
+	bool isFinished(int pid) const;
+	int64_t getFinishedAt(int pid) const;
+	void setFinishedAt(int pid, int64_t finishedAt);
+	void publishDispatch(int pid, int coreId);
+	void publishRelease(int pid, State state, int64_t finishedAt);
+	Snapshot getSnapshot(int pid) const;
+
+	// Full listings are copied in batches, never holding the index lock for the whole set
+	vector<int> getPidsInState(State state);
+	vector<int> getPidsInState(State state, size_t limit);  // at most limit pids, without copying the rest
+	int getCountInState(State state);
+	vector<int> getPidsOnCore(int coreId);
+
+private:
+	static const int CHUNK_BITS = 16;
+	static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+	static const int MAX_CHUNKS = 1 << 12;
+
+	struct Chunk
+	{
+		Chunk();
+
+		std::atomic<int> currentLine[CHUNK_SIZE];
+		std::atomic<int> totalLine[CHUNK_SIZE];
+		std::atomic<int> coreId[CHUNK_SIZE];
+		std::atomic<uint8_t> state[CHUNK_SIZE];
+		std::atomic<int64_t> finishedAt[CHUNK_SIZE];
+		std::atomic<uint32_t> sequence[CHUNK_SIZE];
+
+		// Index bookkeeping, guarded by indexMutex
+		uint8_t indexedState[CHUNK_SIZE];
+		int statePosition[CHUNK_SIZE];
+		int indexedCore[CHUNK_SIZE];
+		int corePosition[CHUNK_SIZE];
+	};
+
+	Chunk* chunkFor(int pid) const;
+	static void beginWrite(Chunk* chunk, int slot);
+	static void endWrite(Chunk* chunk, int slot);
+	void reindex(int pid, Chunk* chunk, int slot);
+	void removeFromIndex(vector<int>& members, int position, bool stateIndex);
+	vector<int> copyInBatches(const vector<int>& members);
+
+	std::array<std::atomic<Chunk*>, MAX_CHUNKS> chunks{};
+	std::atomic<int> pidLimit{ 0 };  // one past the highest pid added
+	std::mutex growMutex;  // serializes chunk growth and addProcess()
+
+	static const int MAX_INDEXED_CORES = 128;
+	static const size_t INDEX_BATCH = 1024;  // pids copied per indexMutex hold
+	std::mutex indexMutex;
+	vector<int> stateMembers[FINISHED + 1];
+	vector<int> coreMembers[MAX_INDEXED_CORES];  // pids whose current or last core is this one
+};
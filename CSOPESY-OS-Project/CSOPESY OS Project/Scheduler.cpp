@@ -1,25 +1,32 @@
 #include "Scheduler.h"
 #include "ConsoleManager.h"
 #include "Screen.h"
-#include "FlatMemoryAllocator.h"
+#include "IMemoryAllocator.h"
+#include "SchedulingPolicy.h"
+#include "HostAffinity.h"
+#include "TraceRecorder.h"
+#include "EmulatorContext.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
 #include <condition_variable>
 #include <mutex>
 #include <vector>
+#include <algorithm>
 
 
 Scheduler::Scheduler(int numCores)
-    : numCores(numCores), schedulerRunning(false),
-    coresUsed(0), coresAvailable(numCores),
-    activeThreads(0),
+    : numCores(std::min(numCores, MAX_CORES)),
     processQueueMutex(), processQueueCondition() {
 }
 
-Scheduler* Scheduler::scheduler = nullptr;
-
 void Scheduler::initialize(int numCores) {
+    // Re-initializing replaces the pool; join the old cores first
+    Scheduler*& scheduler = EmulatorContext::current()->scheduler;
+    if (scheduler != nullptr) {
+        scheduler->stop();
+        delete scheduler;
+    }
     scheduler = new Scheduler(numCores);
 }
 
@@ -29,65 +36,307 @@ Scheduler::~Scheduler() {
 
 Scheduler::Scheduler() {
     this->numCores = -1;
-    this->schedulerRunning = false;
-    this->coresAvailable = 0;
 }
 void Scheduler::start() {
+    std::lock_guard<std::mutex> poolLock(poolMutex);
+    if (schedulerRunning || numCores <= 0) {
+        return;
+    }
     schedulerRunning = true;
-    algorithm = ConsoleManager::getInstance()->getSchedulerConfig();
+
+    // Resolve the policy and its config once; each core runs a loop specialized for it
+    ConsoleManager* consoleManager = ConsoleManager::getInstance();
+    hostCpuMapping = HostAffinity::parseMapping(consoleManager->getCorePinning());
+    tickDuration = instructionDelay(consoleManager->getDelayPerExec());
+    lockstep = consoleManager->getClockMode() == "lockstep";
+    prioritized = consoleManager->getSchedulerConfig() == "priority";
+    agingTicks = std::max(0, consoleManager->getAgingTicks());
+    migrationCost = std::max(0, consoleManager->getMigrationCost());
+    softAffinity = consoleManager->getAffinity() == "soft";
+    memoryStamps = nodeId == 0 && consoleManager->getMemoryStamps();
+    if (lockstep) {
+        tickBarrier = std::make_unique<std::barrier<TickCompletion>>(numCores, TickCompletion{ this });
+    }
+    else {
+        timerThread = EmulatorContext::startThread([this] { runTimer(); });
+    }
+    if (prioritized) {
+        launchCores(PriorityPolicy(consoleManager->getDelayPerExec(), consoleManager->getTimeSlice()));
+    }
+    else if (consoleManager->getSchedulerConfig() == "rr") {
+        launchCores(RoundRobinPolicy(consoleManager->getDelayPerExec(), consoleManager->getTimeSlice()));
+    }
+    else {
+        launchCores(FcfsPolicy(consoleManager->getDelayPerExec()));
+    }
+}
+
+template <typename Policy>
+void Scheduler::launchCores(Policy policy) {
+    // Kept so setNumCores() can start more cores running the same policy
+    spawnCore = [this, policy](int i) {
+        if (static_cast<int>(workerThreads.size()) <= i) {
+            workerThreads.resize(i + 1);
+        }
+        // Cores live until stop() or a shrink, idling between processes instead of exiting
+        int generation = coreGeneration[i].load();
+        workerThreads[i] = EmulatorContext::startThread([this, i, generation, policy]() {
+            pinCore(i);
+            runCore(i, generation, policy);
+            });
+    };
 
     for (int i = 0; i < numCores; i++) {
-        // Launch each core on a separate detached thread
-        std::thread([this, i]() {
-            while (schedulerRunning) {
-                std::shared_ptr<Screen> process;
-
-                // Lock the queue for popping the next process
-                {
-                    std::unique_lock<std::mutex> lock(processQueueMutex);
-                    // Wait for a process to be added to the queue
-                    processQueueCondition.wait(lock, [this]() { return !processQueue.empty() || !schedulerRunning; });
-
-                    if (!schedulerRunning) {
-                        return; // Exit thread if the scheduler is stopping
-                    }
-
-                    // Pop the next process from the queue
-                    process = processQueue.front();
-                    processQueue.pop();
-                    ++activeThreads; // Increment active thread count
-                }
-
-                void* memoryPtr = FlatMemoryAllocator::getInstance()->allocate(process->getMemoryRequired(), process->getProcessName());
-                if (memoryPtr) {
-                    coresAvailable--;
-                    coresUsed++;
-
-                    // Set the core ID for the process being processed
-                    process->setCPUCoreID(i); // Assign the core ID to the process
-
-                    // Process the worker function
-                    workerFunction(i, process, memoryPtr);
-                }
-                else {
-                    addProcessToQueue(process);
-                }
-
-                // Update core tracking after process completion
-                {
-                    std::lock_guard<std::mutex> lock(processQueueMutex);
-                    --activeThreads; // Decrement active thread count
-                    if (processQueue.empty() && activeThreads == 0) {
-                        schedulerRunning = false;
-                        processQueueCondition.notify_all();
-                    }
-
-                    coresUsed--;
-                    coresAvailable++;
-                }
+        spawnCore(i);
+    }
+}
+
+bool Scheduler::setNumCores(int numCores) {
+    numCores = std::max(1, std::min(numCores, MAX_CORES));
+
+    std::lock_guard<std::mutex> poolLock(poolMutex);
+    if (lockstep && schedulerRunning) {
+        return false;  // the tick barrier's participant count is fixed once started
+    }
+    int oldCores = this->numCores;
+    {
+        std::lock_guard<std::mutex> lock(processQueueMutex);
+        for (int i = numCores; i < oldCores; i++) {
+            coreGeneration[i]++;
+        }
+        this->numCores = numCores;
+    }
+    // Wake parked cores so the removed ones can retire
+    processQueueCondition.notify_all();
+
+    if (!schedulerRunning || !spawnCore) {
+        return true;
+    }
+
+    // The queue is shared, so work a retired core would have picked up simply
+    // goes to the remaining cores; its in-flight burst completes normally
+    for (int i = oldCores; i < numCores; i++) {
+        if (i < static_cast<int>(workerThreads.size()) && workerThreads[i].joinable()) {
+            workerThreads[i].join();  // removed by an earlier shrink, possibly still finishing its burst
+        }
+        spawnCore(i);
+    }
+    return true;
+}
+
+int Scheduler::getNumCores() const {
+    return numCores;
+}
+
+template <typename Policy>
+void Scheduler::runCore(int i, int generation, const Policy& policy) {
+    int spinBudget = MIN_SPIN;
+
+    while (true) {
+        std::shared_ptr<Screen> process;
+        int level = 0;
+        uint64_t readySince = 0;
+        if (lockstep) {
+            if (!schedulerRunning) {
+                break;
+            }
+            process = tryPopProcess(i, level, readySince);
+            if (!process) {
+                // An idle core still takes part in every tick
+                policy.executeDelay();
+                tickBarrier->arrive_and_wait();
+                continue;
             }
-            }).detach(); // Detach thread for independent execution
+        }
+        else {
+            process = waitForProcess(i, generation, spinBudget, level, readySince);
+            if (!process) {
+                break; // Scheduler is stopping or this core was removed; its last burst has already been drained
+            }
+        }
+        noteHostCpu(i);  // waking from a park is where the OS most often moves a thread
+
+        void* memoryPtr = getMemoryAllocator()->allocate(process->getMemoryRequired(), process->getPid(), i);
+        if (memoryPtr) {
+            coresUsed++;
+            recordWait(process, readySince);
+
+            // Set the core ID for the process being processed; the old one tells whether it migrated
+            int previousCore = process->getCPUCoreID();
+            process->markDispatched(i); // Assign the core ID to the process
+            TraceRecorder::getInstance()->record(nodeId, i, TraceRecorder::DISPATCH, process->getPid());
+
+            // Process the worker function
+            workerFunction(i, process, memoryPtr, level, previousCore, policy);
+
+            coresUsed--;
+        }
+        else {
+            // Not enough memory yet; put it back and let running processes free some.
+            // It keeps its ready time, so the wait it is finally dispatched with is the whole wait
+            TraceRecorder::getInstance()->record(nodeId, i, TraceRecorder::REQUEUE, process->getPid());
+            enqueue(process, false, readySince);
+            if (lockstep) {
+                policy.executeDelay();
+                tickBarrier->arrive_and_wait();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
     }
+
+    if (lockstep) {
+        tickBarrier->arrive_and_drop();  // let the remaining cores keep ticking while this one leaves
+    }
+}
+
+void Scheduler::pinCore(int core) {
+    HostCpuStats& stats = hostCpuStats[core];
+    stats.pinnedCpu = -1;
+    if (!hostCpuMapping.empty()) {
+        int hostCpu = hostCpuMapping[core % hostCpuMapping.size()];
+        if (HostAffinity::pinCurrentThread(hostCpu)) {
+            stats.pinnedCpu = hostCpu;
+        }
+    }
+    stats.lastCpu = HostAffinity::getCurrentHostCpu();
+}
+
+void Scheduler::noteHostCpu(int core) {
+    HostCpuStats& stats = hostCpuStats[core];
+    int hostCpu = HostAffinity::getCurrentHostCpu();
+    int lastCpu = stats.lastCpu.exchange(hostCpu, std::memory_order_relaxed);
+    if (lastCpu != -1 && lastCpu != hostCpu) {
+        stats.migrations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int Scheduler::getPinnedHostCpu(int core) const {
+    return (core >= 0 && core < MAX_CORES) ? hostCpuStats[core].pinnedCpu.load() : -1;
+}
+
+int Scheduler::getLastHostCpu(int core) const {
+    return (core >= 0 && core < MAX_CORES) ? hostCpuStats[core].lastCpu.load() : -1;
+}
+
+long long Scheduler::getHostMigrations(int core) const {
+    return (core >= 0 && core < MAX_CORES) ? hostCpuStats[core].migrations.load() : 0;
+}
+
+bool Scheduler::isRetired(int core, int generation) const {
+    return coreGeneration[core].load(std::memory_order_relaxed) != generation;
+}
+
+std::shared_ptr<Screen> Scheduler::tryPopProcess(int core, int& level, uint64_t& readySince) {
+    std::lock_guard<std::mutex> lock(processQueueMutex);
+    return popProcessLocked(core, level, readySince);
+}
+
+std::shared_ptr<Screen> Scheduler::popProcessLocked(int core, int& level, uint64_t& readySince) {
+    // Front of the highest non-empty level; level is where the process was taken from
+    uint32_t levels = readyLevels.load(std::memory_order_relaxed);
+    if (levels == 0) {
+        return nullptr;
+    }
+    level = 0;
+    while ((levels & (1u << level)) == 0) {
+        level++;
+    }
+
+    std::deque<ReadyEntry>& queue = readyQueues[level];
+    uint64_t now = cpuTicks.load(std::memory_order_relaxed);
+    auto chosen = queue.begin();
+    if (softAffinity && migrationCost > 0) {
+        // Soft affinity: a process that would have to migrate here is charged the
+        // migration cost, so a warm process may go ahead of one that waited a bit longer
+        uint64_t bestScore = 0;
+        auto end = queue.size() > AFFINITY_WINDOW ? queue.begin() + AFFINITY_WINDOW : queue.end();
+        for (auto candidate = queue.begin(); candidate != end; ++candidate) {
+            int lastCore = candidate->process->getCPUCoreID();
+            uint64_t score = (now - std::min(now, candidate->readySince)) + ((lastCore == -1 || lastCore == core) ? migrationCost : 0);
+            if (candidate == queue.begin() || score > bestScore) {
+                chosen = candidate;
+                bestScore = score;
+            }
+        }
+        if (chosen != queue.begin()) {
+            affinityPicks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    ReadyEntry entry = std::move(*chosen);
+    queue.erase(chosen);
+    if (queue.empty()) {
+        readyLevels.fetch_and(~(1u << level), std::memory_order_relaxed);
+    }
+    queuedProcesses.fetch_sub(1, std::memory_order_relaxed);
+    queuedMemory.fetch_sub(entry.process->getMemoryRequired(), std::memory_order_relaxed);
+    readySince = entry.readySince;
+    return entry.process;
+}
+
+void Scheduler::recordWait(const std::shared_ptr<Screen>& process, uint64_t readySince) {
+    // Counted once the process actually has its memory and a core, not when it is popped
+    uint64_t now = cpuTicks.load(std::memory_order_relaxed);
+    uint64_t wait = now > readySince ? now - readySince : 0;
+    PriorityWaitStats& stats = waitStats[process->getPriority()];
+    stats.dispatches.fetch_add(1, std::memory_order_relaxed);
+    stats.totalWait.fetch_add(wait, std::memory_order_relaxed);
+    uint64_t maxWait = stats.maxWait.load(std::memory_order_relaxed);
+    while (wait > maxWait && !stats.maxWait.compare_exchange_weak(maxWait, wait, std::memory_order_relaxed)) {
+    }
+}
+
+void Scheduler::ageReadyQueues(uint64_t now) {
+    // Each level is ordered by levelSince, so only the fronts can be due
+    std::lock_guard<std::mutex> lock(processQueueMutex);
+    for (int level = 1; level < Screen::NUM_PRIORITIES; level++) {
+        std::deque<ReadyEntry>& queue = readyQueues[level];
+        while (!queue.empty() && now - queue.front().levelSince >= agingTicks) {
+            ReadyEntry entry = std::move(queue.front());
+            queue.pop_front();
+            entry.levelSince = now;
+            readyQueues[level - 1].push_back(std::move(entry));
+            readyLevels.fetch_or(1u << (level - 1), std::memory_order_relaxed);
+        }
+        if (queue.empty()) {
+            readyLevels.fetch_and(~(1u << level), std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Scheduler::higherPriorityReady(int level) const {
+    return (readyLevels.load(std::memory_order_relaxed) & ((1u << level) - 1)) != 0;
+}
+
+std::shared_ptr<Screen> Scheduler::waitForProcess(int core, int generation, int& spinBudget, int& level, uint64_t& readySince) {
+    // Spin phase: a process queued within the budget is picked up without a futex wake
+    bool foundWhileSpinning = false;
+    for (int spin = 0; spin < spinBudget && schedulerRunning && !isRetired(core, generation); spin++) {
+        if (queuedProcesses.load(std::memory_order_acquire) > 0) {
+            foundWhileSpinning = true;
+            break;
+        }
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(processQueueMutex);
+    if (queuedProcesses.load(std::memory_order_relaxed) == 0 && schedulerRunning && !isRetired(core, generation)) {
+        // Park until addProcessToQueue(), setNumCores() or stop() wakes this core
+        spinBudget = std::max(MIN_SPIN, spinBudget / 2);
+        ++parkedWorkers;
+        processQueueCondition.wait(lock, [this, core, generation]() { return queuedProcesses.load(std::memory_order_relaxed) > 0 || !schedulerRunning || isRetired(core, generation); });
+        --parkedWorkers;
+    }
+    else if (foundWhileSpinning) {
+        spinBudget = std::min(MAX_SPIN, spinBudget * 2);
+    }
+
+    if (!schedulerRunning || isRetired(core, generation)) {
+        return nullptr;
+    }
+
+    return popProcessLocked(core, level, readySince);
 }
 
 int Scheduler::getCoresUsed() const {
@@ -95,7 +344,8 @@ int Scheduler::getCoresUsed() const {
 }
 
 int Scheduler::getCoresAvailable() const {
-    return coresAvailable;
+    // A core removed mid-burst still counts as used until the burst ends
+    return std::max(0, numCores - coresUsed);
 }
 
 void Scheduler::stop() {
@@ -104,96 +354,303 @@ void Scheduler::stop() {
         schedulerRunning = false;
     }
     processQueueCondition.notify_all();
-}
 
-void Scheduler::workerFunction(int core, std::shared_ptr<Screen> process, void* memoryPtr) {
-    string timestamp = ConsoleManager::getInstance()->getCurrentTimestamp();
+    // Cores stop at the next instruction boundary, release memory and publish state before joining
+    std::lock_guard<std::mutex> poolLock(poolMutex);
+    for (std::thread& worker : workerThreads) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workerThreads.clear();
 
-    // Ensure the process keeps its original core for FCFS and RR
-    if (process->getCPUCoreID() == -1) {
-        // If core is not yet assigned, set the current core as the affinity core
-        process->setCPUCoreID(core);
+    // Sleeping processes stay WAITING; the timer only needs to notice the flag
+    if (timerThread.joinable()) {
+        timerThread.join();
     }
-    else {
-        // Otherwise, ensure the process stays on its assigned core
-        core = process->getCPUCoreID();
+}
+
+template <typename Policy>
+void Scheduler::workerFunction(int core, std::shared_ptr<Screen> process, void* memoryPtr, int level, int previousCore, const Policy& policy) {
+    // Warm cache: a process back on the core it last ran on starts at full speed.
+    // One that migrated stalls for the migration cost while its cache refills
+    int stall = 0;
+    if (previousCore != -1) {
+        warmDispatches.fetch_add(1, std::memory_order_relaxed);
+        if (previousCore != core) {
+            migrations.fetch_add(1, std::memory_order_relaxed);
+            process->noteMigration();
+            stall = migrationCost;
+        }
+    }
+    for (int i = 0; i < stall && schedulerRunning; i++) {
+        policy.executeDelay();
+        stallTicks.fetch_add(1, std::memory_order_relaxed);
+        if (lockstep) {
+            tickBarrier->arrive_and_wait();
+        }
     }
 
-    if (algorithm == "fcfs") {
-        // First-Come, First-Served logic
-        for (int i = 0; i < process->getTotalLine(); i++) {
-            if (ConsoleManager::getInstance()->getDelayPerExec() != 0) {
-                for (int i = 0; i < ConsoleManager::getInstance()->getDelayPerExec(); i++) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-            else {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Run one burst: to completion for FCFS, up to the quantum for RR, and
+    // cut short by a SLEEP/IO instruction or, under the priority policy, by a
+    // process becoming ready at a higher level than the one this was taken from.
+    // The quantum is counted on the CPU tick clock, the same time base as aging,
+    // sleeps and batch generation; every burst runs at least one instruction
+    int line = process->getCurrentLine();
+    int totalLine = process->getTotalLine();
+    uint64_t burstStart = cpuTicks.load(std::memory_order_acquire);
+    int blockingTicks = 0;
+    bool interrupted = false;
+    while (line < totalLine && blockingTicks == 0) {
+        if (!schedulerRunning) {
+            interrupted = true;  // stop() drains cores at the next instruction boundary
+            break;
+        }
+        policy.executeDelay();
+        noteHostCpu(core);
+        blockingTicks = process->getBlockingTicks(line);
+        process->setCurrentLine(++line);
+        if (lockstep) {
+            tickBarrier->arrive_and_wait();  // no core starts the next instruction until all finished this one
+        }
+        if (policy.quantumExpired(cpuTicks.load(std::memory_order_acquire) - burstStart)) {
+            break;
+        }
+        if constexpr (Policy::prioritized) {
+            if (higherPriorityReady(level)) {
+                break;
             }
-            process->setCurrentLine(process->getCurrentLine() + 1);
         }
-        FlatMemoryAllocator::getInstance()->deallocate(memoryPtr);
     }
 
-    else if (algorithm == "rr") {
-        // Round-Robin logic
-        int quantum = ConsoleManager::getInstance()->getTimeSlice();  // Get RR time slice
-
-        // Process for the duration of the quantum or until the process is finished
-        for (int i = 0; i < quantum && process->getCurrentLine() < process->getTotalLine(); i++) {
-            if (ConsoleManager::getInstance()->getDelayPerExec() != 0) {
-                for (int i = 0; i < ConsoleManager::getInstance()->getDelayPerExec(); i++) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-            else {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
-            process->setCurrentLine(process->getCurrentLine() + 1);
+    // Memory stamps are numbered globally, so only node 0 writes them
+    if constexpr (Policy::preemptive) {
+        if (memoryStamps) {
+            getMemoryAllocator()->printMemoryInfo(policy.quantum);
         }
+    }
 
-        FlatMemoryAllocator::getInstance()->printMemoryInfo(quantum);
+    // deallocate 
+    getMemoryAllocator()->deallocate(memoryPtr, core);
 
-        // deallocate 
-        FlatMemoryAllocator::getInstance()->deallocate(memoryPtr);
+    // A blocked process leaves the core and waits on the timer wheel instead of the ready queue
+    if (blockingTicks > 0 && !process->isFinished()) {
+        TraceRecorder::getInstance()->record(nodeId, core, TraceRecorder::BLOCK, process->getPid(), blockingTicks);
+        process->markWaiting();
+        sleepProcess(process, blockingTicks);
+        return;
+    }
+
+    // publish READY/FINISHED before re-queueing so another core cannot be overwritten
+    TraceRecorder::getInstance()->record(nodeId, core, process->isFinished() ? TraceRecorder::COMPLETE : TraceRecorder::PREEMPT, process->getPid());
+    process->markReleased();
 
+    if (interrupted && !process->isFinished()) {
+        // Resumes first when the scheduler restarts, so a drain does not reorder the queue
+        enqueue(process, true);
+        return;
+    }
 
+    if constexpr (Policy::preemptive) {
         //if process is not finished, re-queue it but retain its core affinity
-        if (process->getCurrentLine() < process->getTotalLine()) {
-            std::lock_guard<std::mutex> lock(processQueueMutex);
-            processQueue.push(process);  // Re-queue the unfinished process
-            processQueueCondition.notify_one();
+        if (!process->isFinished()) {
+            addProcessToQueue(process);  // Re-queue the unfinished process
+        }
+    }
+}
+
+
+void Scheduler::sleepProcess(std::shared_ptr<Screen> process, int ticks) {
+    std::lock_guard<std::mutex> lock(sleepWheelMutex);
+    sleepWheel.schedule(process, ticks);
+}
+
+void Scheduler::runTimer() {
+    // Free-running clock: ticks on a fixed schedule so time does not drift with wake-up latency
+    auto nextTick = std::chrono::steady_clock::now();
+    while (schedulerRunning) {
+        nextTick += tickDuration;
+        std::this_thread::sleep_until(nextTick);
+        onTick();
+    }
+}
+
+void Scheduler::onTick() {
+    uint64_t now = cpuTicks.fetch_add(1, std::memory_order_release) + 1;
+    if (prioritized && agingTicks > 0) {
+        ageReadyQueues(now);
+    }
+
+    std::vector<std::shared_ptr<Screen>> woken;
+    {
+        std::lock_guard<std::mutex> lock(sleepWheelMutex);
+        sleepWheel.advance(woken);
+    }
+    for (std::shared_ptr<Screen>& process : woken) {
+        TraceRecorder::getInstance()->record(nodeId, -1, TraceRecorder::WAKE, process->getPid());
+        process->setState(Screen::READY);
+        addProcessToQueue(process);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(tickMutex);
+    }
+    tickCondition.notify_all();
+}
+
+uint64_t Scheduler::getCpuCycles() const {
+    return cpuTicks.load(std::memory_order_acquire);
+}
+
+bool Scheduler::waitForTick(uint64_t tick, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(tickMutex);
+    return tickCondition.wait_for(lock, timeout, [this, tick]() { return cpuTicks.load(std::memory_order_acquire) >= tick || !schedulerRunning; })
+        && cpuTicks.load(std::memory_order_acquire) >= tick;
+}
+
+bool Scheduler::isLockstep() const {
+    return lockstep;
+}
+
+bool Scheduler::isRunning() const {
+    return schedulerRunning;
+}
+
+void Scheduler::setCpuCycles(uint64_t cycles) {
+    cpuTicks.store(cycles, std::memory_order_release);
+}
+
+std::vector<std::shared_ptr<Screen>> Scheduler::getQueuedProcesses() {
+    std::vector<std::shared_ptr<Screen>> queued;
+    std::lock_guard<std::mutex> lock(processQueueMutex);
+    for (const std::deque<ReadyEntry>& queue : readyQueues) {
+        for (const ReadyEntry& entry : queue) {
+            queued.push_back(entry.process);
         }
     }
+    return queued;
+}
 
-    string timestampFinished = ConsoleManager::getInstance()->getCurrentTimestamp();
-    process->setTimestampFinished(timestampFinished);  // Log completion time
+Scheduler::WaitStats Scheduler::getWaitStats(int priority) const {
+    WaitStats stats;
+    if (priority >= 0 && priority < Screen::NUM_PRIORITIES) {
+        stats.dispatches = waitStats[priority].dispatches.load(std::memory_order_relaxed);
+        stats.totalWait = waitStats[priority].totalWait.load(std::memory_order_relaxed);
+        stats.maxWait = waitStats[priority].maxWait.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+bool Scheduler::isPrioritized() const {
+    return prioritized;
 }
 
+Scheduler::AffinityStats Scheduler::getAffinityStats() const {
+    AffinityStats stats;
+    stats.dispatches = warmDispatches.load(std::memory_order_relaxed);
+    stats.migrations = migrations.load(std::memory_order_relaxed);
+    stats.stallTicks = stallTicks.load(std::memory_order_relaxed);
+    stats.affinityPicks = affinityPicks.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool Scheduler::isSoftAffinity() const {
+    return softAffinity;
+}
+
+void Scheduler::setNode(int nodeId, IMemoryAllocator* memoryAllocator) {
+    this->nodeId = nodeId;
+    this->memoryAllocator = memoryAllocator;
+}
+
+int Scheduler::getNodeId() const {
+    return nodeId;
+}
+
+IMemoryAllocator* Scheduler::getMemoryAllocator() const {
+    return memoryAllocator != nullptr ? memoryAllocator : IMemoryAllocator::getInstance();
+}
+
+int Scheduler::getQueuedCount() const {
+    return queuedProcesses.load(std::memory_order_relaxed);
+}
+
+uint64_t Scheduler::getQueuedMemory() const {
+    return queuedMemory.load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<Screen> Scheduler::stealQueuedProcess() {
+    // Back of the lowest non-empty priority level
+    std::lock_guard<std::mutex> lock(processQueueMutex);
+    for (int level = Screen::NUM_PRIORITIES - 1; level >= 0; level--) {
+        std::deque<ReadyEntry>& queue = readyQueues[level];
+        if (queue.empty()) {
+            continue;
+        }
+        std::shared_ptr<Screen> process = queue.back().process;
+        queue.pop_back();
+        if (queue.empty()) {
+            readyLevels.fetch_and(~(1u << level), std::memory_order_relaxed);
+        }
+        queuedProcesses.fetch_sub(1, std::memory_order_relaxed);
+        queuedMemory.fetch_sub(process->getMemoryRequired(), std::memory_order_relaxed);
+        return process;
+    }
+    return nullptr;
+}
+
+std::vector<std::pair<std::shared_ptr<Screen>, uint64_t>> Scheduler::getSleepingProcesses() {
+    std::vector<std::pair<std::shared_ptr<Screen>, uint64_t>> sleeping;
+    std::lock_guard<std::mutex> lock(sleepWheelMutex);
+    sleeping.reserve(sleepWheel.size());
+    sleepWheel.forEach([&sleeping](const std::shared_ptr<Screen>& process, uint64_t ticksLeft) {
+        sleeping.emplace_back(process, ticksLeft);
+        });
+    return sleeping;
+}
 
 void Scheduler::addProcessToQueue(std::shared_ptr<Screen> process) {
+    enqueue(process, false);
+}
+
+void Scheduler::enqueue(std::shared_ptr<Screen> process, bool atFront, uint64_t readySince) {
+    bool wakeCore;
     {
         std::lock_guard<std::mutex> lock(processQueueMutex);
-        processQueue.push(process);
+        // Every (re)queue starts over at the base priority
+        int level = prioritized ? process->getPriority() : 0;
+        uint64_t now = cpuTicks.load(std::memory_order_relaxed);
+        if (readySince == READY_NOW) {
+            readySince = now;
+        }
+        std::deque<ReadyEntry>& queue = readyQueues[level];
+        if (atFront) {
+            // Keeps the level ordered by levelSince for aging
+            uint64_t levelSince = queue.empty() ? now : std::min(now, queue.front().levelSince);
+            queue.push_front({ process, readySince, levelSince });
+        }
+        else {
+            queue.push_back({ process, readySince, now });
+        }
+        readyLevels.fetch_or(1u << level, std::memory_order_relaxed);
+        queuedMemory.fetch_add(process->getMemoryRequired(), std::memory_order_relaxed);
+        queuedProcesses.fetch_add(1, std::memory_order_release);
+        wakeCore = parkedWorkers > 0;
+    }
+    // Spinning cores see queuedProcesses directly; only parked ones need a notify
+    if (wakeCore) {
+        processQueueCondition.notify_one();
     }
-    processQueueCondition.notify_one();  // Notify one waiting thread
 }
 
 Scheduler* Scheduler::getInstance() {
+    Scheduler*& scheduler = EmulatorContext::current()->scheduler;
     if (scheduler == nullptr) {
         scheduler = new Scheduler();
     }
     return scheduler;
 }
 
-int Scheduler::getCpuCycles() const {
-    return cpuCycles;
-}
-
-void Scheduler::setCpuCycles(int cpuCycles) {
-    this->cpuCycles = cpuCycles;
-}
-
 bool Scheduler::getSchedulerTestRunning() const {
     return schedulerTestRunning;
 }
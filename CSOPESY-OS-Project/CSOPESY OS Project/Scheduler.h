@@ -1,12 +1,23 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
-#include <queue>
+#include <deque>
+#include <utility>
+#include <vector>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <memory>
+#include <atomic>
+#include <functional>
+#include <array>
+#include <chrono>
+#include <barrier>
+#include <cstdint>
 #include "Screen.h"
+#include "TimerWheel.h"
+
+class IMemoryAllocator;
 
 class Scheduler {
 public:
@@ -25,32 +36,172 @@ public:
     void start();
     void stop();
     void addProcessToQueue(std::shared_ptr<Screen> process);
-    void workerFunction(int core, std::shared_ptr<Screen> process, void* ptr);
+    void sleepProcess(std::shared_ptr<Screen> process, int ticks);
+    bool isRunning() const;
     static Scheduler* getInstance();
     static void initialize(int numCores);
+    bool setNumCores(int numCores);
+    int getNumCores() const;
     bool getSchedulerTestRunning() const;
     void setSchedulerTestRunning(int schedulerTestRunning);
 
     int getCoresUsed() const;
     int getCoresAvailable() const;
-    int coresUsed = 0; // Tracks how many cores are currently used
-    int coresAvailable; // Tracks how many cores are available
+    std::atomic<int> coresUsed{ 0 }; // Tracks how many cores are currently used
+
+    // The authoritative CPU tick clock. Free-running mode ticks once per
+    // instruction delay; lockstep mode ticks when every core has executed (or
+    // idled through) one instruction, using a barrier between phases
+    uint64_t getCpuCycles() const;
+    bool waitForTick(uint64_t tick, std::chrono::milliseconds timeout);
+    bool isLockstep() const;
+    void setCpuCycles(uint64_t cycles);  // only while stopped, for restoring a checkpoint
 
-    int getCpuCycles() const;
-    void setCpuCycles(int cpuCycles);
+    // Stable only while the scheduler is stopped; used to write checkpoints
+    std::vector<std::shared_ptr<Screen>> getQueuedProcesses();
+    std::vector<std::pair<std::shared_ptr<Screen>, uint64_t>> getSleepingProcesses();  // process, ticks left
+
+    // Ready-queue wait of processes dispatched so far, in ticks, by base priority
+    struct WaitStats
+    {
+        uint64_t dispatches = 0;
+        uint64_t totalWait = 0;
+        uint64_t maxWait = 0;
+    };
+    WaitStats getWaitStats(int priority) const;
+    bool isPrioritized() const;
+
+    // Simulated cache affinity: a process dispatched on a different core than
+    // it last ran on stalls migration-cost instruction times while its cache
+    // warms up. With affinity "soft" the dispatcher weighs that cost against
+    // how long each ready process has waited
+    struct AffinityStats
+    {
+        uint64_t dispatches = 0;  // dispatches of processes that had run before
+        uint64_t migrations = 0;
+        uint64_t stallTicks = 0;  // instruction times lost to cold caches
+        uint64_t affinityPicks = 0;  // times the dispatcher passed over an older process to keep one warm
+    };
+    AffinityStats getAffinityStats() const;
+    bool isSoftAffinity() const;
+
+    // Cluster node this scheduler runs; each node has its own cores, clock and memory.
+    // Node 0 is the shared instance and uses the shared allocator
+    void setNode(int nodeId, IMemoryAllocator* memoryAllocator);
+    int getNodeId() const;
+    IMemoryAllocator* getMemoryAllocator() const;
+    int getQueuedCount() const;
+    uint64_t getQueuedMemory() const;  // bytes required by the processes in the ready queue
+    // Takes the ready process that would run last, for moving it to another node
+    std::shared_ptr<Screen> stealQueuedProcess();
+
+    // Host CPU placement of each core worker, for the cores command
+    int getPinnedHostCpu(int core) const;  // -1 when the core is not pinned
+    int getLastHostCpu(int core) const;
+    long long getHostMigrations(int core) const;
 
 private:
-    int numCores;
-    int cpuCycles = 0;
-    bool schedulerRunning;
-    int activeThreads;
+    template <typename Policy>
+    void launchCores(Policy policy);
+    template <typename Policy>
+    void runCore(int core, int generation, const Policy& policy);
+    template <typename Policy>
+    void workerFunction(int core, std::shared_ptr<Screen> process, void* ptr, int level, int previousCore, const Policy& policy);
+    std::shared_ptr<Screen> waitForProcess(int core, int generation, int& spinBudget, int& level, uint64_t& readySince);
+    bool isRetired(int core, int generation) const;
+    void pinCore(int core);
+    void noteHostCpu(int core);
+    static constexpr uint64_t READY_NOW = UINT64_MAX;  // enqueue() stamps the current tick as the ready time
+    void enqueue(std::shared_ptr<Screen> process, bool atFront, uint64_t readySince = READY_NOW);
+    void runTimer();
+    void onTick();
+    std::shared_ptr<Screen> tryPopProcess(int core, int& level, uint64_t& readySince);
+    std::shared_ptr<Screen> popProcessLocked(int core, int& level, uint64_t& readySince);
+    void recordWait(const std::shared_ptr<Screen>& process, uint64_t readySince);
+    void ageReadyQueues(uint64_t now);
+    bool higherPriorityReady(int level) const;
+
+    struct TickCompletion
+    {
+        Scheduler* scheduler;
+        void operator()() noexcept {
+            scheduler->onTick();
+        }
+    };
+
+    // Idle cores poll the queue for a bounded number of yields before parking on
+    // the condition variable; the budget doubles when polling finds work and
+    // halves when the core had to park
+    static constexpr int MIN_SPIN = 16;
+    static constexpr int MAX_SPIN = 4096;
+    static constexpr int MAX_CORES = 128;
+    static constexpr int AFFINITY_WINDOW = 8;  // ready entries a soft-affinity dispatch looks at
+
+    std::atomic<int> numCores;
+    // Bumped when a core is removed; a worker exits once its generation is stale,
+    // so a core removed and re-added is never confused with its replacement
+    std::array<std::atomic<int>, MAX_CORES> coreGeneration{};
+
+    struct HostCpuStats
+    {
+        std::atomic<int> pinnedCpu{ -1 };
+        std::atomic<int> lastCpu{ -1 };
+        std::atomic<long long> migrations{ 0 };  // times the worker was seen on a different host CPU
+    };
+    std::array<HostCpuStats, MAX_CORES> hostCpuStats;
+    std::vector<int> hostCpuMapping;  // from core-pinning; empty leaves placement to the OS
+
+    // Processes blocked by SLEEP/IO wait here, off-core, until their tick comes up
+    TimerWheel<std::shared_ptr<Screen>> sleepWheel;
+    std::mutex sleepWheelMutex;
+    std::thread timerThread;
+    std::chrono::milliseconds tickDuration{ 100 };  // one instruction's worth of delay
+
+    std::atomic<uint64_t> cpuTicks{ 0 };
+    bool lockstep = false;
+    std::unique_ptr<std::barrier<TickCompletion>> tickBarrier;  // lockstep only, one participant per core
+    std::mutex tickMutex;
+    std::condition_variable tickCondition;
+    std::atomic<bool> schedulerRunning{ false };
+    std::atomic<int> queuedProcesses{ 0 };  // processes in readyQueues, readable without the lock
+    std::atomic<uint64_t> queuedMemory{ 0 };
+    int nodeId = 0;
+    IMemoryAllocator* memoryAllocator = nullptr;  // nullptr uses IMemoryAllocator::getInstance()
+    int parkedWorkers = 0;  // cores blocked on processQueueCondition, guarded by processQueueMutex
     bool schedulerTestRunning = false;
-    std::vector<std::thread> workerThreads;
-    std::queue<std::shared_ptr<Screen>> processQueue;
+    std::vector<std::thread> workerThreads;  // indexed by core, guarded by poolMutex
+    std::function<void(int)> spawnCore;  // starts core i with the policy chosen in start()
+    std::mutex poolMutex;
+    // One FIFO per priority level, guarded by processQueueMutex. Without a
+    // priority policy every process uses level 0, so it is a single FIFO
+    struct ReadyEntry
+    {
+        std::shared_ptr<Screen> process;
+        uint64_t readySince;  // tick the process became ready, for wait statistics
+        uint64_t levelSince;  // tick it reached its current level, for aging
+    };
+    std::array<std::deque<ReadyEntry>, Screen::NUM_PRIORITIES> readyQueues;
+    std::atomic<uint32_t> readyLevels{ 0 };  // bit per non-empty level, read without the lock to check for preemption
+    bool prioritized = false;
+    uint64_t agingTicks = 0;  // ticks a ready process waits before moving up one level; 0 disables aging
+
+    struct PriorityWaitStats
+    {
+        std::atomic<uint64_t> dispatches{ 0 };
+        std::atomic<uint64_t> totalWait{ 0 };
+        std::atomic<uint64_t> maxWait{ 0 };
+    };
+    std::array<PriorityWaitStats, Screen::NUM_PRIORITIES> waitStats;
+
+    int migrationCost = 0;  // instruction times a migrated process stalls
+    bool softAffinity = false;
+    bool memoryStamps = true;  // node 0 of an emulator that writes memory_stamp files
+    std::atomic<uint64_t> warmDispatches{ 0 };
+    std::atomic<uint64_t> migrations{ 0 };
+    std::atomic<uint64_t> stallTicks{ 0 };
+    std::atomic<uint64_t> affinityPicks{ 0 };
     std::mutex processQueueMutex;
     std::condition_variable processQueueCondition;
-    static Scheduler* scheduler;
-    string algorithm = "";
 };
 
 #endif // SCHEDULER_H
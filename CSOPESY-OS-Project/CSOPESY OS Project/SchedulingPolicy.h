@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// Scheduling policies for Scheduler::runCore. The scheduler picks one policy
+// in start() from the config, copies the relevant values into it, and runs
+// the core loop as a template instantiated on that policy, so the per-line
+// loop has no string compares or config lookups. A policy provides:
+//   quantumExpired(ticks)  - whether a process that has been on the core for
+//                            this many CPU ticks has used up its time slice
+//   executeDelay()         - sleep for one instruction
+//   preemptive             - whether unfinished processes go back to the queue
+//   prioritized            - whether a higher-priority ready process cuts the burst short
+
+// Wall time of one instruction: delay-per-exec ticks of 100ms, minimum one tick
+inline std::chrono::milliseconds instructionDelay(int delayPerExec)
+{
+    return std::chrono::milliseconds(100) * std::max(delayPerExec, 1);
+}
+
+// First-Come, First-Served: a process runs to completion once dispatched
+struct FcfsPolicy
+{
+    static constexpr bool preemptive = false;
+    static constexpr bool prioritized = false;
+
+    explicit FcfsPolicy(int delayPerExec)
+        : delay(instructionDelay(delayPerExec)) {
+    }
+
+    bool quantumExpired(uint64_t ticks) const {
+        return false;
+    }
+
+    void executeDelay() const {
+        std::this_thread::sleep_for(delay);
+    }
+
+    std::chrono::milliseconds delay;
+};
+
+// Round-Robin: a process runs for at most quantum ticks, then is re-queued
+struct RoundRobinPolicy
+{
+    static constexpr bool preemptive = true;
+    static constexpr bool prioritized = false;
+
+    RoundRobinPolicy(int delayPerExec, int quantum)
+        : delay(instructionDelay(delayPerExec)), quantum(std::max(quantum, 1)) {
+    }
+
+    bool quantumExpired(uint64_t ticks) const {
+        return ticks >= static_cast<uint64_t>(quantum);
+    }
+
+    void executeDelay() const {
+        std::this_thread::sleep_for(delay);
+    }
+
+    std::chrono::milliseconds delay;
+    int quantum;
+};
+
+// Preemptive priority: the core takes from the highest non-empty priority
+// level and runs for at most quantum ticks, yielding early as soon as a process is
+// ready at a higher level. Waiting processes age upward (see aging-ticks), so
+// low priorities are not starved
+struct PriorityPolicy
+{
+    static constexpr bool preemptive = true;
+    static constexpr bool prioritized = true;
+
+    PriorityPolicy(int delayPerExec, int quantum)
+        : delay(instructionDelay(delayPerExec)), quantum(std::max(quantum, 1)) {
+    }
+
+    bool quantumExpired(uint64_t ticks) const {
+        return ticks >= static_cast<uint64_t>(quantum);
+    }
+
+    void executeDelay() const {
+        std::this_thread::sleep_for(delay);
+    }
+
+    std::chrono::milliseconds delay;
+    int quantum;
+};
@@ -7,28 +7,29 @@
 #include <thread>
 #include <chrono>
 #include <fstream>
-#include <random>
+#include "WorkloadRandom.h"
+#include <algorithm>
 #include "ConsoleManager.h"
+#include "ProcessNameTable.h"
+#include "ProcessTable.h"
 
 using namespace std;
 
 namespace fs = std::filesystem; // alias for convenience
 
 Screen::Screen(string processName, int currentLine, string timestamp, size_t memoryRequired)
-	: BaseScreen(processName), cpuCoreID(-1), commandCounter(0), currentState(ProcessState::READY)
+	: BaseScreen(processName), commandCounter(0)
 {
+	this->pid = ProcessNameTable::getInstance()->intern(processName);
+	ProcessTable::getInstance()->addProcess(this->pid);
 	this->processName = processName;
-	this->currentLine = currentLine;
+	this->setCurrentLine(currentLine);
 	this->setRandomIns();
 	this->memoryRequired = memoryRequired;
 	this->timestamp = timestamp;
 
 
-	// create 100 print commands
-	for (int i = 0; i < totalLine; i++) {
-		this->printCommands.push_back(PrintCommand(i, "Printing from " + processName + " " + std::to_string(i)));
-
-	}
+	this->loadProgram(generateBlocking(processName, this->getTotalLine()));
 
 	/*
 	for(int i = 0; i < this->printCommands.size(); i++){
@@ -38,11 +39,52 @@ Screen::Screen(string processName, int currentLine, string timestamp, size_t mem
 
 }
 
+Screen::Screen(string processName, string timestamp, size_t memoryRequired, int totalLine, const vector<BlockingInstruction>& blocking)
+	: BaseScreen(processName), commandCounter(0)
+{
+	this->pid = ProcessNameTable::getInstance()->intern(processName);
+	ProcessTable::getInstance()->addProcess(this->pid);
+	this->processName = processName;
+	this->setTotalLine(totalLine);
+	this->memoryRequired = memoryRequired;
+	this->timestamp = timestamp;
+	this->loadProgram(blocking);
+}
+
+vector<Screen::BlockingInstruction> Screen::generateBlocking(const string& processName, int totalLine) {
+	// io-frequency percent of the instructions are SLEEP/IO instructions that block the process
+	int ioFrequency = ConsoleManager::getInstance()->getIoFrequency();
+	int maxIoTicks = std::max(1, ConsoleManager::getInstance()->getMaxIoTicks());
+	WorkloadRandom random(WorkloadRandom::INSTRUCTION_MIX, processName);
+	vector<BlockingInstruction> blocking;
+	for (int i = 0; i < totalLine; i++) {
+		if (ioFrequency > 0 && random.uniform(0, 99) < ioFrequency) {
+			ICommand::CommandType type = random.uniform(0, 99) < 50 ? ICommand::SLEEP : ICommand::IO;
+			blocking.push_back({ i, type, random.uniform(1, maxIoTicks) });
+		}
+	}
+	return blocking;
+}
+
+void Screen::loadProgram(const vector<BlockingInstruction>& blocking) {
+	// blocking is sorted by line; the lines between its entries are PRINTs
+	this->commands.clear();
+	this->commands.reserve(this->getTotalLine());
+	size_t next = 0;
+	for (int i = 0; i < this->getTotalLine(); i++) {
+		if (next < blocking.size() && blocking[next].line == i) {
+			this->commands.push_back(std::make_shared<SleepCommand>(this->pid, blocking[next].type, blocking[next].ticks));
+			next++;
+		}
+		else {
+			this->commands.push_back(std::make_shared<PrintCommand>(this->pid, "Printing from " + this->processName + " " + std::to_string(i)));
+		}
+	}
+}
+
 void Screen::setRandomIns() {
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	std::uniform_int_distribution<> dis(ConsoleManager::getInstance()->getMinIns(), ConsoleManager::getInstance()->getMaxIns());
-	this->totalLine = dis(gen);
+	WorkloadRandom random(WorkloadRandom::INSTRUCTION_COUNT, this->processName);
+	this->setTotalLine(random.uniform(ConsoleManager::getInstance()->getMinIns(), ConsoleManager::getInstance()->getMaxIns()));
 }
 
 Screen::~Screen()
@@ -56,12 +98,12 @@ void Screen::setProcessName(string processName)
 
 void Screen::setCurrentLine(int currentLine)
 {
-	this->currentLine = currentLine;
+	ProcessTable::getInstance()->setCurrentLine(this->pid, currentLine);
 }
 
 void Screen::setTotalLine(int totalLine)
 {
-	this->totalLine = totalLine;
+	ProcessTable::getInstance()->setTotalLine(this->pid, totalLine);
 }
 
 void Screen::setTimestamp(string timestamp)
@@ -76,12 +118,12 @@ string Screen::getProcessName()
 
 int Screen::getCurrentLine()
 {
-	return this->currentLine;
+	return ProcessTable::getInstance()->getCurrentLine(this->pid);
 }
 
 int Screen::getTotalLine()
 {
-	return this->totalLine;
+	return ProcessTable::getInstance()->getTotalLine(this->pid);
 }
 
 string Screen::getTimestamp()
@@ -90,27 +132,28 @@ string Screen::getTimestamp()
 }
 
 string Screen::getTimestampFinished() {
-	return timestampFinished;
+	time_t finishedAt = static_cast<time_t>(ProcessTable::getInstance()->getFinishedAt(this->pid));
+	return finishedAt == 0 ? "" : ConsoleManager::getInstance()->formatTimestamp(finishedAt);
 }
 
-void Screen::setTimestampFinished(string timestampFinished) {
-	this->timestampFinished = timestampFinished;
+void Screen::setTimestampFinished(time_t timestampFinished) {
+	ProcessTable::getInstance()->setFinishedAt(this->pid, static_cast<int64_t>(timestampFinished));
 }
 
 
 void Screen::executeCurrentCommand()
 {
-	this->printCommands[this->currentLine].execute();
+	this->commands[this->getCurrentLine()]->execute();
 }
 
 void Screen::moveToNextLine()
 {
-	this->currentLine++;
+	this->setCurrentLine(this->getCurrentLine() + 1);
 }
 
 bool Screen::isFinished() const
 {
-	return this->currentLine >= this->totalLine;
+	return ProcessTable::getInstance()->isFinished(this->pid);
 }
 
 int Screen::getCommandCounter() const
@@ -120,17 +163,68 @@ int Screen::getCommandCounter() const
 
 int Screen::getCPUCoreID() const
 {
-	return this->cpuCoreID;
+	return ProcessTable::getInstance()->getCoreId(this->pid);
 }
 
 Screen::ProcessState Screen::getState() const
 {
-	return this->currentState;
+	return static_cast<ProcessState>(ProcessTable::getInstance()->getState(this->pid));
+}
+
+void Screen::setState(ProcessState state)
+{
+	ProcessTable::getInstance()->setState(this->pid, static_cast<ProcessTable::State>(state));
 }
 
 void Screen::setCPUCoreID(int coreID)
 {
-	this->cpuCoreID = coreID;
+	ProcessTable::getInstance()->setCoreId(this->pid, coreID);
+}
+
+void Screen::markDispatched(int coreID)
+{
+	// core and state change in one seqlock write so readers never see half a dispatch
+	ProcessTable::getInstance()->publishDispatch(this->pid, coreID);
+}
+
+void Screen::markReleased()
+{
+	if (this->isFinished()) {
+		ProcessTable::getInstance()->publishRelease(this->pid, ProcessTable::FINISHED, static_cast<int64_t>(time(nullptr)));
+	}
+	else {
+		ProcessTable::getInstance()->publishRelease(this->pid, ProcessTable::READY, 0);
+	}
+}
+
+void Screen::markWaiting()
+{
+	ProcessTable::getInstance()->publishRelease(this->pid, ProcessTable::WAITING, 0);
+}
+
+int Screen::getBlockingTicks(int line) const
+{
+	if (line < 0 || line >= static_cast<int>(this->commands.size())) {
+		return 0;
+	}
+	return this->commands[line]->getBlockingTicks();
+}
+
+vector<Screen::BlockingInstruction> Screen::getBlockingInstructions() const
+{
+	vector<BlockingInstruction> blocking;
+	for (int line = 0; line < static_cast<int>(this->commands.size()); line++) {
+		int ticks = this->commands[line]->getBlockingTicks();
+		if (ticks > 0) {
+			blocking.push_back({ line, this->commands[line]->getCommandType(), ticks });
+		}
+	}
+	return blocking;
+}
+
+ProcessTable::Snapshot Screen::getSnapshot() const
+{
+	return ProcessTable::getInstance()->getSnapshot(this->pid);
 }
 
 void Screen::createFile()
@@ -157,6 +251,11 @@ void Screen::viewFile()
 	file.close();
 }
 
+int Screen::getPid() const
+{
+	return this->pid;
+}
+
 size_t Screen::getMemoryRequired() const
 {
 	return this->memoryRequired;
@@ -165,4 +264,34 @@ size_t Screen::getMemoryRequired() const
 void Screen::setMemoryRequired(size_t memoryRequired)
 {
 	this->memoryRequired = memoryRequired;
+}
+
+int Screen::getPriority() const
+{
+	return this->priority;
+}
+
+void Screen::setNode(int nodeId)
+{
+	this->nodeId.store(nodeId, std::memory_order_relaxed);
+}
+
+int Screen::getNode() const
+{
+	return this->nodeId.load(std::memory_order_relaxed);
+}
+
+void Screen::noteMigration()
+{
+	this->migrations.fetch_add(1, std::memory_order_relaxed);
+}
+
+int Screen::getMigrations() const
+{
+	return this->migrations.load(std::memory_order_relaxed);
+}
+
+void Screen::setPriority(int priority)
+{
+	this->priority = std::clamp(priority, HIGHEST_PRIORITY, LOWEST_PRIORITY);
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #pragma once
 #include "BaseScreen.h"
 #include "PrintCommand.h"
+#include "SleepCommand.h"
+#include <memory>
+#include <atomic>
+#include "ProcessTable.h"
+#include <ctime>
 #include <vector>
 #include <fstream>
 
@@ -10,7 +15,19 @@ using namespace std;
 class Screen : public BaseScreen
 {
 public:
+	// One SLEEP/IO line of a process's program; every other line is a PRINT
+	struct BlockingInstruction
+	{
+		int line;
+		ICommand::CommandType type;
+		int ticks;
+	};
+
 	Screen(string processName, int currentLine, string timestamp, size_t memoryRequired);
+	// Rebuilds a process with a known program, e.g. from a checkpoint
+	Screen(string processName, string timestamp, size_t memoryRequired, int totalLine, const vector<BlockingInstruction>& blocking);
+	// The seeded SLEEP/IO lines a generated process with this name and length gets
+	static vector<BlockingInstruction> generateBlocking(const string& processName, int totalLine);
 	~Screen();
 
 	enum ProcessState
@@ -21,13 +38,19 @@ public:
 		FINISHED
 	};
 
+	// Priority 0 is the highest; screen -s processes default to it and generated ones are lower
+	static const int HIGHEST_PRIORITY = 0;
+	static const int LOWEST_PRIORITY = 7;
+	static const int NUM_PRIORITIES = LOWEST_PRIORITY + 1;
+
 
 	void setProcessName(string processName);
 	void setCurrentLine(int currentLine);
 	void setTotalLine(int totalLine);
 	void setTimestamp(string timestamp);
-	void setTimestampFinished(string timestampFinished);
+	void setTimestampFinished(time_t timestampFinished);
 	void setMemoryRequired(size_t memoryRequired);
+	void setPriority(int priority);  // before the process is first queued
 
 
 	void executeCurrentCommand();
@@ -40,8 +63,21 @@ public:
 	void viewFile();
 	void setRandomIns();
 	size_t getMemoryRequired() const;
+	int getPriority() const;
+	void setNode(int nodeId);
+	int getNode() const;  // cluster node the process is queued or running on
+	void noteMigration();
+	int getMigrations() const;  // dispatches onto a different core than the previous one
+	int getPid() const;
 
 	ProcessState getState() const;
+	void setState(ProcessState state);
+	void markDispatched(int coreID);
+	void markReleased();
+	void markWaiting();
+	int getBlockingTicks(int line) const;
+	vector<BlockingInstruction> getBlockingInstructions() const;
+	ProcessTable::Snapshot getSnapshot() const;
 
 	string getProcessName() override;
 	int getCurrentLine() override;
@@ -50,15 +86,17 @@ public:
 	string getTimestampFinished();
 
 private:
+	void loadProgram(const vector<BlockingInstruction>& blocking);
+
+	// currentLine, totalLine, cpuCoreID and the state live in the ProcessTable under this pid
+	int pid;
 	string processName;
-	int currentLine;
-	int totalLine;
 	int commandCounter;
-	int cpuCoreID = -1;
 	string timestamp;
-	string timestampFinished;
-	std::vector<PrintCommand> printCommands;
-	ProcessState currentState;
+	std::vector<std::shared_ptr<ICommand>> commands;
 	size_t memoryRequired;
+	int priority = HIGHEST_PRIORITY;
+	std::atomic<int> migrations{ 0 };
+	std::atomic<int> nodeId{ 0 };
 
 };
@@ -0,0 +1,225 @@
+#include "SimulatedMemory.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+SimulatedMemory::SimulatedMemory(size_t size, const string& backing)
+	: length(size)
+{
+	if (length == 0) {
+		return;
+	}
+
+	if (backing.empty() || backing == "anonymous") {
+		mapAnonymous();
+	}
+	else {
+		mapFile(backing);
+		if (base == nullptr) {
+			cerr << "Warning: could not map " << backing << "; using anonymous memory instead." << endl;
+			mapAnonymous();
+		}
+	}
+
+	if (base == nullptr) {
+		// Uninitialized on purpose: large heap blocks are still paged in lazily by most allocators
+		heap.reset(new char[length]);
+		base = heap.get();
+		kind = HEAP;
+	}
+}
+
+SimulatedMemory::~SimulatedMemory()
+{
+	unmap();
+}
+
+#ifdef _WIN32
+
+void SimulatedMemory::mapAnonymous()
+{
+	// Address space only; commit() adds commit charge range by range as memory is handed out
+	base = static_cast<char*>(VirtualAlloc(nullptr, length, MEM_RESERVE, PAGE_READWRITE));
+	kind = ANONYMOUS;
+}
+
+bool SimulatedMemory::commit(size_t offset, size_t count) const
+{
+	if (kind != ANONYMOUS || offset >= length || count == 0) {
+		return true;
+	}
+	// Committed pages are demand-zero: no physical page is used until first touched.
+	// Committing a page twice is allowed, so neighbouring ranges may share a page
+	return VirtualAlloc(base + offset, std::min(count, length - offset), MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void SimulatedMemory::mapFile(const string& path)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	ULARGE_INTEGER size;
+	size.QuadPart = length;
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return;
+	}
+	base = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, length));
+	if (base == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	kind = FILE_BACKED;
+	this->path = path;
+}
+
+void SimulatedMemory::unmap()
+{
+	if (kind == ANONYMOUS && base != nullptr) {
+		VirtualFree(base, 0, MEM_RELEASE);
+	}
+	else if (kind == FILE_BACKED) {
+		UnmapViewOfFile(base);
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+	}
+	base = nullptr;
+}
+
+size_t SimulatedMemory::getResidentBytes() const
+{
+	if (kind == HEAP) {
+		return SIZE_MAX;
+	}
+
+	// A page counts once it is in the working set, i.e. it has been touched
+	size_t resident = 0;
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	size_t pageSize = info.dwPageSize;
+	std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages;
+	const size_t batch = 4096;
+	for (size_t offset = 0; offset < length; offset += batch * pageSize) {
+		size_t count = std::min(batch, (length - offset + pageSize - 1) / pageSize);
+		pages.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			pages[i].VirtualAddress = base + offset + i * pageSize;
+		}
+		if (!QueryWorkingSetEx(GetCurrentProcess(), pages.data(), static_cast<DWORD>(count * sizeof(pages[0])))) {
+			return SIZE_MAX;
+		}
+		for (const auto& page : pages) {
+			if (page.VirtualAttributes.Valid) {
+				resident += pageSize;
+			}
+		}
+	}
+	return std::min(resident, length);
+}
+
+#else
+
+void SimulatedMemory::mapAnonymous()
+{
+	void* region = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	base = (region == MAP_FAILED) ? nullptr : static_cast<char*>(region);
+	kind = ANONYMOUS;
+}
+
+bool SimulatedMemory::commit(size_t offset, size_t count) const
+{
+	// MAP_NORESERVE already leaves every page to be supplied on first touch
+	return true;
+}
+
+void SimulatedMemory::mapFile(const string& path)
+{
+	int descriptor = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (descriptor < 0) {
+		return;
+	}
+	// Growing the file leaves a sparse hole, so no disk blocks are written up front
+	if (ftruncate(descriptor, static_cast<off_t>(length)) != 0) {
+		close(descriptor);
+		return;
+	}
+	void* region = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	if (region == MAP_FAILED) {
+		close(descriptor);
+		return;
+	}
+	base = static_cast<char*>(region);
+	fileDescriptor = descriptor;
+	kind = FILE_BACKED;
+	this->path = path;
+}
+
+void SimulatedMemory::unmap()
+{
+	if (kind != HEAP && base != nullptr) {
+		munmap(base, length);
+	}
+	if (fileDescriptor >= 0) {
+		close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+	base = nullptr;
+}
+
+size_t SimulatedMemory::getResidentBytes() const
+{
+	if (kind == HEAP) {
+		return SIZE_MAX;
+	}
+
+	size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t pages = (length + pageSize - 1) / pageSize;
+	std::vector<unsigned char> residency(pages);
+	if (mincore(base, length, residency.data()) != 0) {
+		return SIZE_MAX;
+	}
+	size_t resident = 0;
+	for (unsigned char page : residency) {
+		if (page & 1) {
+			resident += pageSize;
+		}
+	}
+	return std::min(resident, length);
+}
+
+#endif
+
+string_view SimulatedMemory::view(size_t offset, size_t count) const
+{
+	if (offset >= length || !commit(offset, count)) {
+		return string_view();
+	}
+	return string_view(base + offset, std::min(count, length - offset));
+}
+
+string SimulatedMemory::describe() const
+{
+	string backing = (kind == FILE_BACKED) ? "file " + path : (kind == ANONYMOUS) ? "anonymous mapping" : "heap";
+	string description = to_string(length) + " bytes, " + backing;
+	size_t resident = getResidentBytes();
+	if (resident != SIZE_MAX) {
+		description += ", " + to_string(resident) + " bytes resident";
+	}
+	return description;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Simulated physical memory backed by a virtual memory mapping instead of a
+// filled vector. The region is reserved up front but the OS only supplies a
+// page when it is first touched, so a multi-GB max-overall-mem starts
+// instantly and costs only what the processes actually use.
+//
+// backing is "anonymous" (or empty) for a private zero-filled mapping, or the
+// path of a file to map shared, which leaves the memory contents on disk
+// after the emulator exits. Uses mmap on POSIX and VirtualAlloc /
+// MapViewOfFile on Windows; if mapping fails it falls back to the heap.
+//
+// On Windows the anonymous region is only reserved, so it does not count
+// against the commit limit either; allocators commit() each range before
+// handing it out. Committed ranges stay committed after they are freed.
+class SimulatedMemory
+{
+public:
+	SimulatedMemory(size_t size, const string& backing = "anonymous");
+	~SimulatedMemory();
+
+	SimulatedMemory(const SimulatedMemory&) = delete;
+	SimulatedMemory& operator=(const SimulatedMemory&) = delete;
+
+	char* data() const { return base; }
+	size_t size() const { return length; }
+	char& operator[](size_t index) const { return base[index]; }
+
+	// Makes a range usable before it is handed out; false if the system cannot back it
+	bool commit(size_t offset, size_t count) const;
+	// Read-only window into the memory without copying it; clipped to the region and committed
+	string_view view(size_t offset, size_t count) const;
+
+	// Bytes currently backed by physical pages, or SIZE_MAX when the platform cannot tell
+	size_t getResidentBytes() const;
+	string describe() const;
+
+private:
+	enum Kind
+	{
+		ANONYMOUS,
+		FILE_BACKED,
+		HEAP
+	};
+
+	void mapAnonymous();
+	void mapFile(const string& path);
+	void unmap();
+
+	char* base = nullptr;
+	size_t length = 0;
+	Kind kind = ANONYMOUS;
+	string path;
+	unique_ptr<char[]> heap;  // fallback when no mapping could be made
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fileDescriptor = -1;
+#endif
+};
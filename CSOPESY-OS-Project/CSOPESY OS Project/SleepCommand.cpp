@@ -0,0 +1,57 @@
+/**
+ *  SleepCommand.cpp
+ *
+ *  Purpose:
+ *      This file implements the SleepCommand class, which inherits from ICommand.
+ *      It represents SLEEP and IO instructions: the process gives up its core
+ *      and waits in the WAITING state for a number of ticks before it is
+ *      ready to run again. The waiting itself is done by the scheduler's
+ *      timer wheel, so no core is held while the process sleeps.
+ */
+#include "SleepCommand.h"
+
+ /*----------------------------------------------------------------------
+  |  Function SleepCommand(int pid, CommandType commandType, int ticks)
+  |
+  |  Purpose:  Constructor for the SleepCommand class.
+  |
+  |  Parameters:
+  |      pid (IN) -- The ID of the process that owns or executes this command.
+  |      commandType (IN) -- SLEEP or IO.
+  |      ticks (IN) -- How many scheduler ticks the process stays blocked.
+  |
+  |  Returns:  Nothing (constructor)
+  *-------------------------------------------------------------------*/
+SleepCommand::SleepCommand(int pid, CommandType commandType, int ticks) : ICommand(pid, commandType)
+{
+	this->ticks = ticks;
+}
+
+/*---------------------------------------------------------------------
+ |  Function execute()
+ |
+ |  Purpose:  Nothing happens on the core; the scheduler blocks the process
+ |      for getBlockingTicks() ticks after this command.
+ |
+ |  Parameters: None
+ |
+ |  Returns:  Nothing
+ *-------------------------------------------------------------------*/
+void SleepCommand::execute()
+{
+	ICommand::execute();
+}
+
+/*---------------------------------------------------------------------
+ |  Function getBlockingTicks()
+ |
+ |  Purpose:  Returns how long the process must wait after this command.
+ |
+ |  Parameters: None
+ |
+ |  Returns:  Number of ticks
+ *-------------------------------------------------------------------*/
+int SleepCommand::getBlockingTicks() const
+{
+	return this->ticks;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "ICommand.h"
+class SleepCommand : public ICommand
+{
+public:
+	SleepCommand(int pid, CommandType commandType, int ticks);
+	void execute() override;
+	int getBlockingTicks() const override;
+
+private:
+	int ticks;
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Hierarchical timer wheel used to wake blocked processes after a number of
+// ticks. Level 0 has one slot per tick; each higher level covers 64 times the
+// span of the level below and is cascaded down when the lower level wraps, so
+// scheduling and advancing are O(1) per timer regardless of how many are pending.
+template <typename T>
+class TimerWheel
+{
+public:
+	static constexpr int LEVEL_BITS = 6;
+	static constexpr int SLOTS = 1 << LEVEL_BITS;
+	static constexpr int LEVELS = 4;
+	static constexpr uint64_t MAX_DELAY = (uint64_t(1) << (LEVEL_BITS * LEVELS)) - 1;
+
+	// Fires item after delay ticks (at least one)
+	void schedule(T item, uint64_t delay)
+	{
+		if (delay == 0) {
+			delay = 1;
+		}
+		if (delay > MAX_DELAY) {
+			delay = MAX_DELAY;
+		}
+		place(Entry{ now + delay, std::move(item) });
+		pending++;
+	}
+
+	// Moves time forward one tick and appends the timers that fired to expired
+	void advance(std::vector<T>& expired)
+	{
+		now++;
+
+		// Highest level whose lower levels all wrapped on this tick
+		int topLevel = 0;
+		while (topLevel + 1 < LEVELS && (now & ((uint64_t(1) << (LEVEL_BITS * (topLevel + 1))) - 1)) == 0) {
+			topLevel++;
+		}
+		for (int level = topLevel; level > 0; level--) {
+			std::vector<Entry>& slot = wheels[level][(now >> (LEVEL_BITS * level)) & (SLOTS - 1)];
+			std::vector<Entry> cascading;
+			cascading.swap(slot);
+			for (Entry& entry : cascading) {
+				place(std::move(entry));
+			}
+		}
+
+		std::vector<Entry>& due = wheels[0][now & (SLOTS - 1)];
+		for (Entry& entry : due) {
+			expired.push_back(std::move(entry.item));
+		}
+		pending -= due.size();
+		due.clear();
+	}
+
+	size_t size() const
+	{
+		return pending;
+	}
+
+	uint64_t getNow() const
+	{
+		return now;
+	}
+
+	// Calls visit(item, remainingTicks) for every pending timer, in no particular order
+	template <typename Visitor>
+	void forEach(Visitor visit) const
+	{
+		for (const auto& level : wheels) {
+			for (const std::vector<Entry>& slot : level) {
+				for (const Entry& entry : slot) {
+					visit(entry.item, entry.deadline - now);
+				}
+			}
+		}
+	}
+
+private:
+	struct Entry
+	{
+		uint64_t deadline;
+		T item;
+	};
+
+	void place(Entry entry)
+	{
+		uint64_t delta = entry.deadline - now;
+		int level = 0;
+		while (level + 1 < LEVELS && delta >= (uint64_t(1) << (LEVEL_BITS * (level + 1)))) {
+			level++;
+		}
+		wheels[level][(entry.deadline >> (LEVEL_BITS * level)) & (SLOTS - 1)].push_back(std::move(entry));
+	}
+
+	std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> wheels;
+	uint64_t now = 0;
+	size_t pending = 0;
+};
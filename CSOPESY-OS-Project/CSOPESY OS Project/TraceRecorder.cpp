@@ -0,0 +1,161 @@
+#include "TraceRecorder.h"
+#include "Cluster.h"
+#include "ProcessNameTable.h"
+#include <fstream>
+#include "EmulatorContext.h"
+
+static_assert(TraceRecorder::MAX_NODES >= Cluster::MAX_NODES, "every cluster node needs its own tracks");
+
+TraceRecorder::TraceRecorder()
+	: epoch(std::chrono::steady_clock::now())
+{
+}
+
+TraceRecorder* TraceRecorder::getInstance()
+{
+	// one per emulator context, created with it
+	return EmulatorContext::current()->traceRecorder;
+}
+
+void TraceRecorder::setEnabled(bool enabled)
+{
+	this->enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool TraceRecorder::isEnabled() const
+{
+	return this->enabled.load(std::memory_order_relaxed);
+}
+
+void TraceRecorder::clear()
+{
+	for (auto& nodeTracks : tracks) {
+		for (Track& track : nodeTracks) {
+			std::lock_guard<std::mutex> lock(track.mutex);
+			track.events.clear();
+			track.next = 0;
+			track.wrapped = false;
+		}
+	}
+}
+
+void TraceRecorder::append(int node, int core, EventType type, int pid, int64_t arg)
+{
+	Track& track = tracks[(node < 0 || node >= MAX_NODES) ? 0 : node][(core < 0 || core >= MAX_CORES) ? SCHEDULER_TRACK : core];
+	int64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+
+	std::lock_guard<std::mutex> lock(track.mutex);
+	if (track.events.size() < EVENTS_PER_TRACK) {
+		track.events.push_back(Event{ timestamp, arg, pid, type });
+		return;
+	}
+	track.events[track.next] = Event{ timestamp, arg, pid, type };
+	track.next = (track.next + 1) % EVENTS_PER_TRACK;
+	track.wrapped = true;
+}
+
+static string escapeJson(const string& text)
+{
+	string escaped;
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+			escaped += c;
+		}
+		else if (static_cast<unsigned char>(c) >= 0x20) {
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+bool TraceRecorder::exportChromeTrace(const string& path)
+{
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	auto separator = [&]() -> std::ofstream& {
+		if (!first) {
+			file << ",\n";
+		}
+		first = false;
+		return file;
+	};
+
+	// pid is the node and tid the core, so the cores of different nodes never share a track
+	for (int node = 0; node < MAX_NODES; node++) {
+		bool namedNode = false;
+		for (int trackId = 0; trackId <= MAX_CORES; trackId++) {
+			Track& track = tracks[node][trackId];
+			std::vector<Event> events;
+			{
+				// Copy out under the lock so recording cores are held up only briefly
+				std::lock_guard<std::mutex> lock(track.mutex);
+				if (track.wrapped) {
+					events.insert(events.end(), track.events.begin() + track.next, track.events.end());
+					events.insert(events.end(), track.events.begin(), track.events.begin() + track.next);
+				}
+				else {
+					events = track.events;
+				}
+			}
+			if (events.empty()) {
+				continue;
+			}
+
+			if (!namedNode) {
+				separator() << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << node
+					<< ",\"args\":{\"name\":\"Node " << node << "\"}}";
+				namedNode = true;
+			}
+			string trackName = (trackId == SCHEDULER_TRACK) ? "Scheduler" : "Core " + to_string(trackId);
+			separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << node << ",\"tid\":" << trackId
+				<< ",\"args\":{\"name\":\"" << trackName << "\"}}";
+
+			for (const Event& event : events) {
+				string processName = escapeJson(ProcessNameTable::getInstance()->getName(event.pid));
+				std::ofstream& out = separator();
+				out << "{\"pid\":" << node << ",\"tid\":" << trackId << ",\"ts\":" << event.timestamp << ",";
+
+				switch (event.type) {
+				case DISPATCH:
+					// Slices on a core's track form its Gantt chart
+					out << "\"ph\":\"B\",\"cat\":\"sched\",\"name\":\"" << processName << "\",\"args\":{\"pid\":" << event.pid << "}}";
+					break;
+				case PREEMPT:
+				case BLOCK:
+				case COMPLETE:
+					out << "\"ph\":\"E\",\"cat\":\"sched\",\"args\":{\"reason\":\""
+						<< (event.type == PREEMPT ? "preempted" : event.type == BLOCK ? "blocked" : "completed") << "\"";
+					if (event.type == BLOCK) {
+						out << ",\"ticks\":" << event.arg;
+					}
+					out << "}}";
+					break;
+				default:
+				{
+					const char* name = event.type == REQUEUE ? "requeue"
+						: event.type == WAKE ? "wake"
+						: event.type == ALLOC_OK ? "alloc"
+						: event.type == ALLOC_FAIL ? "alloc failed" : "free";
+					const char* category = (event.type == ALLOC_OK || event.type == ALLOC_FAIL || event.type == FREE) ? "memory" : "sched";
+					out << "\"ph\":\"i\",\"s\":\"t\",\"cat\":\"" << category << "\",\"name\":\"" << name
+						<< "\",\"args\":{\"pid\":" << event.pid << ",\"process\":\"" << processName << "\"";
+					if (event.type == ALLOC_OK || event.type == ALLOC_FAIL) {
+						out << ",\"bytes\":" << event.arg;
+					}
+					out << "}}";
+					break;
+				}
+				}
+			}
+		}
+	}
+
+	file << "\n]}\n";
+	return file.good();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Records scheduling and memory events into one ring buffer per core of each
+// cluster node and exports them as Chrome trace-event JSON, which Perfetto
+// (ui.perfetto.dev) and chrome://tracing show as a timeline with one process
+// per node and one thread per core. Each core only appends to
+// its own buffer, so recording costs an uncontended lock and a store; when
+// tracing is off it costs a single relaxed load.
+class TraceRecorder
+{
+	friend class EmulatorContext;
+
+public:
+	enum EventType : uint8_t
+	{
+		DISPATCH,    // process starts a burst on a core
+		PREEMPT,     // quantum expired, process goes back to the ready queue
+		BLOCK,       // SLEEP/IO instruction, process moves to WAITING
+		COMPLETE,    // last instruction executed
+		REQUEUE,     // dispatch abandoned, e.g. not enough memory
+		WAKE,        // timer wheel moved a process back to READY
+		ALLOC_OK,
+		ALLOC_FAIL,
+		FREE
+	};
+
+	static const int MAX_NODES = 16;
+	static const int MAX_CORES = 128;
+	static const int SCHEDULER_TRACK = MAX_CORES;  // events not tied to a core (timer, generator)
+	static const size_t EVENTS_PER_TRACK = 1 << 16;  // oldest events are overwritten beyond this
+
+	static TraceRecorder* getInstance();
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+	void clear();
+
+	// core -1 records on the node's scheduler track
+	void record(int node, int core, EventType type, int pid, int64_t arg = 0)
+	{
+		if (enabled.load(std::memory_order_relaxed)) {
+			append(node, core, type, pid, arg);
+		}
+	}
+
+	bool exportChromeTrace(const string& path);
+
+private:
+	TraceRecorder();
+
+	struct Event
+	{
+		int64_t timestamp;  // microseconds since the recorder was created
+		int64_t arg;
+		int pid;
+		EventType type;
+	};
+
+	struct Track
+	{
+		std::mutex mutex;
+		std::vector<Event> events;
+		size_t next = 0;  // ring position of the next write
+		bool wrapped = false;
+	};
+
+	void append(int node, int core, EventType type, int pid, int64_t arg);
+
+	std::atomic<bool> enabled{ false };
+	std::chrono::steady_clock::time_point epoch;
+	std::array<std::array<Track, MAX_CORES + 1>, MAX_NODES> tracks;  // node -> core -> track
+};
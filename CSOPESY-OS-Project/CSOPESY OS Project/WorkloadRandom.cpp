@@ -0,0 +1,126 @@
+#include "WorkloadRandom.h"
+#include <atomic>
+#include <random>
+#include <vector>
+#include "EmulatorContext.h"
+
+static uint64_t splitMix64(uint64_t& x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static uint64_t hashKey(const string& key)
+{
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (unsigned char c : key) {
+		hash = (hash ^ c) * 0x100000001B3ull;
+	}
+	return hash;
+}
+
+// High and low words of a 64x64-bit product, without compiler-specific 128-bit types
+static uint64_t multiplyHigh(uint64_t a, uint64_t b, uint64_t& low)
+{
+	uint64_t aLow = a & 0xFFFFFFFFull, aHigh = a >> 32;
+	uint64_t bLow = b & 0xFFFFFFFFull, bHigh = b >> 32;
+	uint64_t lowLow = aLow * bLow;
+	uint64_t highLow = aHigh * bLow;
+	uint64_t lowHigh = aLow * bHigh;
+	uint64_t highHigh = aHigh * bHigh;
+	uint64_t middle = (lowLow >> 32) + (highLow & 0xFFFFFFFFull) + lowHigh;
+	low = (middle << 32) | (lowLow & 0xFFFFFFFFull);
+	return highHigh + (highLow >> 32) + (middle >> 32);
+}
+
+static uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+void WorkloadRandom::setSeed(uint64_t seed)
+{
+	if (seed == 0) {
+		std::random_device rd;
+		seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+	}
+	// Each emulator context has its own seed, shared by every stream it draws from
+	EmulatorContext::current()->workloadSeed = seed;
+}
+
+uint64_t WorkloadRandom::getSeed()
+{
+	return EmulatorContext::current()->workloadSeed;
+}
+
+WorkloadRandom::WorkloadRandom(uint64_t seed)
+{
+	// splitmix64 expands one word into a well-mixed, never all-zero state
+	for (uint64_t& word : state) {
+		word = splitMix64(seed);
+	}
+}
+
+WorkloadRandom::WorkloadRandom(Stream stream, const string& key)
+	: WorkloadRandom(EmulatorContext::current()->workloadSeed ^ (static_cast<uint64_t>(stream) * 0xD1B54A32D192ED03ull) ^ hashKey(key))
+{
+}
+
+WorkloadRandom& WorkloadRandom::forThread(Stream stream)
+{
+	// Threads are numbered as they first draw, so each gets a distinct sequence
+	static std::atomic<uint64_t> nextThread{ 0 };
+	thread_local std::vector<WorkloadRandom> generators;
+	if (generators.empty()) {
+		string key = "thread " + to_string(nextThread.fetch_add(1));
+		for (uint64_t i = 0; i <= PLACEMENT; i++) {
+			generators.emplace_back(static_cast<Stream>(i), key);
+		}
+	}
+	return generators[stream];
+}
+
+uint64_t WorkloadRandom::next()
+{
+	// xoshiro256**
+	uint64_t result = rotl(state[1] * 5, 7) * 9;
+	uint64_t t = state[1] << 17;
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = rotl(state[3], 45);
+	return result;
+}
+
+uint64_t WorkloadRandom::uniform(uint64_t low, uint64_t high)
+{
+	if (high <= low) {
+		return low;
+	}
+	uint64_t range = high - low + 1;
+	if (range == 0) {
+		return next();  // full 64-bit range
+	}
+	// Lemire's multiply-shift with rejection of the biased low products
+	uint64_t threshold = (0 - range) % range;
+	while (true) {
+		uint64_t productLow;
+		uint64_t productHigh = multiplyHigh(next(), range, productLow);
+		if (productLow >= threshold) {
+			return low + productHigh;
+		}
+	}
+}
+
+int WorkloadRandom::uniform(int low, int high)
+{
+	if (high <= low) {
+		return low;
+	}
+	return low + static_cast<int>(uniform(uint64_t(0), static_cast<uint64_t>(static_cast<int64_t>(high) - low)));
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Seeded random numbers for workload generation. Every random property of a
+// process comes from its own stream, a xoshiro256** generator seeded from the
+// emulator context's workload seed, the stream id and the process name. A
+// process therefore gets the same instruction count, memory size, instruction
+// mix and priority on every run with the same seed and config, whichever
+// thread creates it and whatever order processes are created in. Draws that are not tied to a
+// process (e.g. node placement) use a per-thread generator for each stream.
+//
+// Bounded draws use Lemire's multiply-shift rather than the std
+// distributions, whose output differs between standard libraries.
+class WorkloadRandom
+{
+public:
+	enum Stream : uint64_t
+	{
+		INSTRUCTION_COUNT = 1,
+		MEMORY_SIZE,
+		INSTRUCTION_MIX,
+		PRIORITY,
+		PLACEMENT
+	};
+
+	// seed 0 picks a random seed, which getSeed() then reports so the run can be repeated
+	static void setSeed(uint64_t seed);
+	static uint64_t getSeed();
+
+	WorkloadRandom(Stream stream, const string& key);
+	static WorkloadRandom& forThread(Stream stream);
+
+	uint64_t next();
+	uint64_t uniform(uint64_t low, uint64_t high);  // inclusive on both ends
+	int uniform(int low, int high);
+
+private:
+	explicit WorkloadRandom(uint64_t seed);
+
+	uint64_t state[4];
+};
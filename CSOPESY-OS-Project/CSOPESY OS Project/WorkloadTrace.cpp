@@ -0,0 +1,117 @@
+#include "WorkloadTrace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+bool WorkloadTrace::open(const string& path, string& error)
+{
+	file.open(path);
+	if (!file) {
+		error = "could not open " + path;
+		return false;
+	}
+
+	size_t dot = path.find_last_of('.');
+	string extension = (dot == string::npos) ? "" : path.substr(dot + 1);
+	if (extension == "swf") {
+		format = SWF;
+	}
+	else if (extension == "csv") {
+		format = CSV;
+	}
+	return true;
+}
+
+bool WorkloadTrace::next(Job& job)
+{
+	string line;
+	while (getline(file, line)) {
+		lineNumber++;
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == string::npos || line[first] == ';' || line[first] == '#') {
+			continue;
+		}
+
+		if (format == UNKNOWN) {
+			format = (line.find(',') != string::npos) ? CSV : SWF;
+		}
+		bool parsed = (format == SWF) ? parseSwf(line, job) : parseCsv(line, job);
+		if (parsed) {
+			return true;
+		}
+		skipped++;
+	}
+	return false;
+}
+
+bool WorkloadTrace::parseSwf(const string& line, Job& job)
+{
+	// Archives store some fields (e.g. average CPU time) with decimals, so every field is read as a double
+	istringstream fields(line);
+	vector<double> values;
+	string token;
+	while (fields >> token) {
+		char* end = nullptr;
+		double value = strtod(token.c_str(), &end);
+		if (end == token.c_str() || *end != '\0') {
+			return false;
+		}
+		values.push_back(value);
+	}
+	if (values.size() < 18 || values[1] < 0 || values[3] <= 0) {
+		return false;
+	}
+
+	job.name = "J" + to_string(llround(values[0]));
+	job.arrival = static_cast<uint64_t>(llround(values[1]));
+	job.instructions = static_cast<uint64_t>(std::max(1LL, llround(values[3])));
+	double memoryKb = values[6] > 0 ? values[6] : values[9];
+	job.memory = memoryKb > 0 ? llround(memoryKb * 1024) : -1;
+	job.priority = values[14] >= 0 ? static_cast<int>(llround(values[14])) : -1;
+	return true;
+}
+
+bool WorkloadTrace::parseCsv(const string& line, Job& job)
+{
+	vector<string> fields;
+	istringstream stream(line);
+	string field;
+	while (getline(stream, field, ',')) {
+		size_t begin = field.find_first_not_of(" \t\r");
+		size_t end = field.find_last_not_of(" \t\r");
+		fields.push_back(begin == string::npos ? "" : field.substr(begin, end - begin + 1));
+	}
+
+	try {
+		if (fields.size() < 2) {
+			return false;
+		}
+		long long arrival = stoll(fields[0]);
+		long long instructions = stoll(fields[1]);
+		if (arrival < 0 || instructions <= 0) {
+			return false;
+		}
+		job.arrival = static_cast<uint64_t>(arrival);
+		job.instructions = static_cast<uint64_t>(instructions);
+		job.memory = (fields.size() > 2 && !fields[2].empty()) ? stoll(fields[2]) : -1;
+		job.priority = (fields.size() > 3 && !fields[3].empty()) ? stoi(fields[3]) : -1;
+	}
+	catch (...) {
+		return false;  // includes the header line
+	}
+
+	job.name = (fields.size() > 4 && !fields[4].empty()) ? fields[4] : "J" + to_string(lineNumber);
+	return true;
+}
+
+WorkloadTrace::Format WorkloadTrace::getFormat() const
+{
+	return format;
+}
+
+int WorkloadTrace::getSkipped() const
+{
+	return skipped;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+// Streaming reader for recorded job traces. Jobs are read one line at a time
+// as the replay reaches them, so a trace of any length costs one line of
+// memory. Two formats are accepted:
+//
+//   Standard Workload Format (.swf): ';' comment lines, then 18 whitespace
+//   separated fields per job. Used are job number (1), submit time (2), run
+//   time (4), used memory in KB (7, else requested memory 10) and queue
+//   number (15), taken as the priority.
+//
+//   CSV: '#' comment lines and an optional header, then
+//   arrival_tick,instructions[,memory_bytes[,priority[,name]]]
+//
+// The format is taken from the extension, or from the first job line (a
+// comma means CSV) when the extension is neither. Fields given as -1 or left
+// out are unknown and filled in from the seeded workload streams by the
+// replay. Malformed lines and jobs without a run time are skipped.
+class WorkloadTrace
+{
+public:
+	enum Format
+	{
+		UNKNOWN,
+		SWF,
+		CSV
+	};
+
+	struct Job
+	{
+		string name;
+		uint64_t arrival;  // SWF seconds or CSV ticks, relative to the trace start
+		uint64_t instructions;
+		long long memory;  // bytes, -1 when unknown
+		int priority;  // -1 when unknown
+	};
+
+	bool open(const string& path, string& error);
+	// Reads the next job; false once the trace is exhausted
+	bool next(Job& job);
+
+	Format getFormat() const;
+	int getSkipped() const;
+
+private:
+	bool parseSwf(const string& line, Job& job);
+	bool parseCsv(const string& line, Job& job);
+
+	ifstream file;
+	std::atomic<Format> format{ UNKNOWN };
+	int lineNumber = 0;
+	std::atomic<int> skipped{ 0 };  // read by the replay status while the replay thread parses
+};
@@ -27,13 +27,12 @@ using namespace std;
 #include "BaseScreen.h"
 #include "MainScreen.h"
 #include "Scheduler.h"
-#include "FlatMemoryAllocator.h"
 #include <fstream>
 #include <random>
 
 
 
-int main()
+int main(int argc, char* argv[])
 {
     ConsoleManager::initialize();
     InputManager::initialize();
@@ -43,15 +42,36 @@ int main()
     ConsoleManager::getInstance()->registerConsole(mainScreen);
     ConsoleManager::getInstance()->setCurrentConsole(mainScreen);
 
-    bool running = true;
-    ConsoleManager::getInstance()->drawConsole();
+    // --script <file> runs a command script non-interactively; "-" reads the commands from stdin
+    string scriptPath = "";
+    for (int i = 1; i + 1 < argc; i++) {
+        if (string(argv[i]) == "--script") {
+            scriptPath = argv[i + 1];
+        }
+    }
 
-    const size_t maximumMemorySize = 16384;
-    FlatMemoryAllocator::initialize(maximumMemorySize);
+    if (!scriptPath.empty()) {
+        ifstream scriptFile;
+        if (scriptPath != "-") {
+            scriptFile.open(scriptPath);
+            if (!scriptFile) {
+                cerr << "Error: Could not open script " << scriptPath << endl;
+                return 1;
+            }
+        }
+        InputManager::getInstance()->runScript(scriptPath == "-" ? cin : scriptFile);
+        if (ConsoleManager::getInstance()->isRunning()) {
+            ConsoleManager::getInstance()->exitApplication();
+        }
+    }
+    else {
+        bool running = true;
+        ConsoleManager::getInstance()->drawConsole();
 
-    while (running) {
-        InputManager::getInstance()->handleMainConsoleInput();
-        running = ConsoleManager::getInstance()->isRunning();
+        while (running) {
+            InputManager::getInstance()->handleMainConsoleInput();
+            running = ConsoleManager::getInstance()->isRunning();
+        }
     }
 
     InputManager::getInstance()->destroy();
@@ -59,4 +79,3 @@ int main()
 
     return 0;
 }
-